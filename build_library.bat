@@ -3,8 +3,8 @@ setlocal enabledelayedexpansion
 
 set defines=/D FASTER_PLOT_LIBRARY=1
 set include_paths=/I..\raylib50
-set src_files=..\src\faster_plot.cpp ..\src\utils.cpp ..\src\functions.cpp ..\src\function_parsing.cpp ..\src\lexer.cpp ..\src\command_parser.cpp ..\src\object_operations.cpp ..\src\gui_elements.cpp ..\src\data_manager.cpp ..\src\app_loop.cpp ..\resources\font.cpp
-set obj_files=faster_plot.obj utils.obj functions.obj function_parsing.obj lexer.obj command_parser.obj object_operations.obj gui_elements.obj data_manager.obj app_loop.obj font.obj
+set src_files=..\src\faster_plot.cpp ..\src\utils.cpp ..\src\functions.cpp ..\src\function_parsing.cpp ..\src\function_fit.cpp ..\src\data_filters.cpp ..\src\fft.cpp ..\src\thread_pool.cpp ..\src\data_stream.cpp ..\src\lexer.cpp ..\src\command_parser.cpp ..\src\object_operations.cpp ..\src\gui_elements.cpp ..\src\data_manager.cpp ..\src\app_loop.cpp ..\src\plot_lod.cpp ..\src\plot_renderer.cpp ..\src\plot_x_index.cpp ..\src\plot_image.cpp ..\src\csv_parser.cpp ..\src\mapped_file.cpp ..\src\plot_file.cpp ..\resources\font.cpp
+set obj_files=faster_plot.obj utils.obj functions.obj function_parsing.obj function_fit.obj data_filters.obj fft.obj thread_pool.obj data_stream.obj lexer.obj command_parser.obj object_operations.obj gui_elements.obj data_manager.obj app_loop.obj plot_lod.obj plot_renderer.obj plot_x_index.obj plot_image.obj csv_parser.obj mapped_file.obj plot_file.obj font.obj
 set libs=gdi32.lib msvcrt.lib ..\raylib50\raylib.lib user32.lib shell32.lib winmm.lib
 set CFlags=/O2 /EHsc /std:c++20 /c
 
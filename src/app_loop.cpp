@@ -4,15 +4,41 @@
 
 #include "data_manager.hpp"
 #include "faster_plot.hpp"
+#include "global_vars.hpp"
 #include "utils.hpp"
 
+// Returns true, if there was any input since the last frame, which can change what is drawn.
+static bool has_input_events()
+{
+    if (IsWindowResized() || IsFileDropped() || GetKeyPressed() != 0)
+	return true;
+
+    Vector2 mouse_delta = GetMouseDelta();
+    Vector2 wheel_move = GetMouseWheelMoveV();
+    if (mouse_delta.x != 0 || mouse_delta.y != 0 || wheel_move.x != 0 || wheel_move.y != 0)
+	return true;
+
+    for (int button = MOUSE_BUTTON_LEFT; button <= MOUSE_BUTTON_MIDDLE; ++button) {
+	if (IsMouseButtonPressed(button) || IsMouseButtonReleased(button))
+	    return true;
+    }
+    return false;
+}
+
 // primary application loop
-bool app_loop(Text_Input &text_input, Content_Tree& content_tree, FPlot::Faster_Plot_flags flags)
+// A frame is only drawn, if something marked it dirty. Otherwise the last frame stays on screen and only the input is polled.
+// With wait_for_events the idle loop blocks until the next input event, which is only possible while no cursor is blinking
+// and nobody else (like the library API between frames, or a stream) can change the data.
+bool app_loop(Text_Input &text_input, Content_Tree& content_tree, FPlot::Faster_Plot_flags flags, bool wait_for_events)
 {
     using namespace FPlot;
     
     if (!WindowShouldClose())
     {
+	if (has_input_events()) {
+	    g_frame_dirty = true;
+	}
+	
 	handle_dropped_files();
 	
 	if (check_flag(flags, FPL_TEXT_INPUT)) {
@@ -20,6 +46,20 @@ bool app_loop(Text_Input &text_input, Content_Tree& content_tree, FPlot::Faster_
 	}
 
 	data_manager.update_viewport();
+
+	if (!g_frame_dirty) {
+	    if (wait_for_events && !(check_flag(flags, FPL_TEXT_INPUT) && text_input.is_active()) && !data_manager.is_loading() && !data_manager.is_fitting()
+		&& !data_manager.is_streaming()) {
+		EnableEventWaiting();
+	    }
+	    else {
+		DisableEventWaiting();
+		WaitTime(1.0 / TARGET_FPS);
+	    }
+	    PollInputEvents();
+	    return true;
+	}
+	g_frame_dirty = false;
 	
 	if (check_flag(flags, FPL_CONTENT_TREE)) {
 	    data_manager.update_content_tree(content_tree);
@@ -38,10 +78,12 @@ bool app_loop(Text_Input &text_input, Content_Tree& content_tree, FPlot::Faster_
 		content_tree.draw();
 	    }
 	}
+	DisableEventWaiting();
 	EndDrawing();
 	return true;
     }
     else {
+	data_manager.unload_gpu_resources();
 	CloseWindow();
 	return false;
     }
@@ -59,10 +101,12 @@ bool app_loop()
 	    ClearBackground(WHITE);
 	    data_manager.draw();
 	}
+	DisableEventWaiting();
 	EndDrawing();
 	return true;
     }
     else {
+	data_manager.unload_gpu_resources();
 	CloseWindow();
 	return false;
     }
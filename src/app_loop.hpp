@@ -3,5 +3,5 @@
 #include "gui_elements.hpp"
 #include "faster_plot.hpp"
 
-bool app_loop(Text_Input &text_input, Content_Tree& content_tree, FPlot::Faster_Plot_flags flags);
+bool app_loop(Text_Input &text_input, Content_Tree& content_tree, FPlot::Faster_Plot_flags flags, bool wait_for_events = false);
 bool app_loop();
@@ -4,16 +4,22 @@
 
 #include "command_parser.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <limits>
+#include <memory>
+#include <numeric>
 
 #include "functions.hpp"
 #include "global_vars.hpp"
 #include "utils.hpp"
 #include "lexer.hpp"
 #include "object_operations.hpp"
+#include "data_filters.hpp"
 #include "data_manager.hpp"
+#include "plot_image.hpp"
 
 void Command_Object::delete_new_object() {
     if (new_object) {
@@ -203,7 +209,9 @@ static Command_Object get_command_object(Lexer &lexer)
 		return {};
 	    }
 	    
-	    object.obj.val_ptr = &plot_data->x->y[lexer.tkn(2).i];
+	    object.obj.val_ptr = const_cast<double*>(plot_data->x->y.data()) + lexer.tkn(2).i; // written with set_value only
+	    object.value_owner = plot_data->x;
+	    object.value_idx = lexer.tkn(2).i;
 	    
 	    lexer.tkn_idx += 4;
 	}
@@ -225,7 +233,9 @@ static Command_Object get_command_object(Lexer &lexer)
 		return {};
 	    }
 	    
-	    object.obj.val_ptr = &plot_data->y[lexer.tkn(2).i];
+	    object.obj.val_ptr = const_cast<double*>(plot_data->y.data()) + lexer.tkn(2).i; // written with set_value only
+	    object.value_owner = plot_data;
+	    object.value_idx = lexer.tkn(2).i;
 	    
 	    lexer.tkn_idx += 4;
 	}
@@ -310,6 +320,33 @@ static Command_Operator get_command_operator(Token tkn)
     case tkn_new:
 	op.type = OP_new;
 	break;
+    case tkn_cancel:
+	op.type = OP_cancel;
+	break;
+    case tkn_bench:
+	op.type = OP_bench;
+	break;
+    case tkn_bound:
+	op.type = OP_bound;
+	break;
+    case tkn_fft:
+	op.type = OP_fft;
+	break;
+    case tkn_psd:
+	op.type = OP_psd;
+	break;
+    case tkn_conv:
+	op.type = OP_conv;
+	break;
+    case tkn_xcorr:
+	op.type = OP_xcorr;
+	break;
+    case tkn_capacity:
+	op.type = OP_capacity;
+	break;
+    case tkn_render:
+	op.type = OP_render;
+	break;
     }
     return op;
 }
@@ -320,9 +357,19 @@ void op_binary_assign(Lexer& lexer, Command_Object& object, Command_Operator& op
     case OT_plot_data:
 	
 	if (arg_unary.type == OT_function && arg_binary.type == OT_function) {
-	    for (size_t ix = 0; ix < object.obj.plot_data->size(); ++ix) {
-		double x = object.obj.plot_data->x ? object.obj.plot_data->x->y[ix] : ix;
-		object.obj.plot_data->y[ix] = op_fun(arg_unary.obj.function->operator()(x), arg_binary.obj.function->operator()(x));
+	    size_t size = object.obj.plot_data->size();
+	    std::vector<double> x(size);
+	    if (object.obj.plot_data->x)
+		std::copy(object.obj.plot_data->x->y.begin(), object.obj.plot_data->x->y.begin() + size, x.begin());
+	    else
+		std::iota(x.begin(), x.end(), 0.0);
+	    
+	    std::vector<double> binary_values(size);
+	    arg_binary.obj.function->evaluate_many(x.data(), binary_values.data(), size);
+	    std::vector<double>& y = object.obj.plot_data->y.edit();
+	    arg_unary.obj.function->evaluate_many(x.data(), y.data(), size);
+	    for (size_t ix = 0; ix < size; ++ix) {
+		y[ix] = op_fun(y[ix], binary_values[ix]);
 	    }
 	}
 	else if (arg_unary.type == OT_plot_data && arg_binary.type == OT_plot_data) {
@@ -332,9 +379,10 @@ void op_binary_assign(Lexer& lexer, Command_Object& object, Command_Operator& op
 	    }
 
 	    size_t new_obj_size = std::min(arg_unary.obj.plot_data->size(), arg_binary.obj.plot_data->size());
-	    object.obj.plot_data->y.resize(new_obj_size, 0);
+	    std::vector<double>& y = object.obj.plot_data->y.edit();
+	    y.resize(new_obj_size, 0);
 	    for (size_t ix = 0; ix < new_obj_size; ++ix) {
-		object.obj.plot_data->y[ix] = op_fun(arg_unary.obj.plot_data->y[ix], arg_binary.obj.plot_data->y[ix]);
+		y[ix] = op_fun(arg_unary.obj.plot_data->y[ix], arg_binary.obj.plot_data->y[ix]);
 	    }
 	    object.obj.plot_data->x = arg_unary.obj.plot_data->x;
 	}
@@ -354,12 +402,22 @@ void op_binary_assign(Lexer& lexer, Command_Object& object, Command_Operator& op
 		return;
 	    }
 
-	    object.obj.plot_data->y.resize(plot_data->size(), 0);
+	    std::vector<double> function_values(plot_data->size());
+	    if (plot_data->x)
+		function->evaluate_many(plot_data->x->y.data(), function_values.data(), function_values.size());
+	    else {
+		std::iota(function_values.begin(), function_values.end(), 0.0);
+		function->evaluate_many(function_values.data(), function_values.data(), function_values.size());
+	    }
+	    
+	    std::vector<double>& y = object.obj.plot_data->y.edit();
+	    y.resize(plot_data->size(), 0);
 	    for (size_t ix = 0; ix < plot_data->size(); ++ix) {
-		object.obj.plot_data->y[ix] = op_fun(plot_data->y[ix], function->operator()(plot_data->x ? plot_data->x->y[ix] : ix));
+		y[ix] = op_fun(plot_data->y[ix], function_values[ix]);
 	    }
 	    object.obj.plot_data->x = plot_data->x;
-	}	
+	}
+	object.obj.plot_data->modified();
 	break;
 	
     case OT_function:
@@ -391,7 +449,7 @@ void op_binary_assign(Lexer& lexer, Command_Object& object, Command_Operator& op
 	    break;
 	}
 
-	*object.obj.val_ptr = op_fun(unary_val, binary_val);
+	object.set_value(op_fun(unary_val, binary_val));
 	break;
     }
 
@@ -404,6 +462,7 @@ void op_unary_assign(Lexer& lexer, Command_Object& object, Command_Object& arg_u
 	if (arg_unary.type == OT_plot_data) {
 	    object.obj.plot_data->x = arg_unary.obj.plot_data->x;
 	    object.obj.plot_data->y = arg_unary.obj.plot_data->y;
+	    object.obj.plot_data->modified();
 	    return;
 	}
 	break;
@@ -445,10 +504,10 @@ void op_unary_assign(Lexer& lexer, Command_Object& object, Command_Object& arg_u
     case OT_value_ptr:
 	switch (arg_unary.type) {
 	case OT_value_ptr:
-	    *object.obj.val_ptr = *arg_unary.obj.val_ptr;
+	    object.set_value(*arg_unary.obj.val_ptr);
 	    return;
 	case OT_value:
-	    *object.obj.val_ptr = arg_unary.obj.val;
+	    object.set_value(arg_unary.obj.val);
 	    return;
 	default:
 	    return;
@@ -518,6 +577,87 @@ void op_extrema_assign(Lexer &lexer, Command_Object& object, [[maybe_unused]] Co
     get_extrema_plot_data(object.obj.plot_data, arg_unary.obj.plot_data);
 }
 
+// data = fft data [phase], data = psd data [window <type>], data = conv data data, data = xcorr data data
+void op_spectrum_assign(Lexer &lexer, Command_Object& object, Command_Operator& op, Command_Object& arg_unary, Command_Object& arg_binary)
+{
+    if (object.type != OT_plot_data) {
+	lexer.parsing_error(object.tkn, "Expected data, but got '%s'.", object_type_name_table[object.type]);
+	return;
+    }
+
+    if (arg_unary.type != OT_plot_data) {
+	lexer.parsing_error(arg_unary.tkn, "Expected data, but got '%s'.", object_type_name_table[arg_unary.type]);
+	return;
+    }
+
+    if (op_arg_cnt_table[op.type] >= 2 && arg_binary.type != OT_plot_data) {
+	lexer.parsing_error(arg_binary.tkn, "Expected data, but got '%s'.", object_type_name_table[arg_binary.type]);
+	return;
+    }
+
+    bool success = false;
+    switch (op.type) {
+    case OP_fft:
+	{
+	    bool phase = false;
+	    if (lexer.tkn(1).type == tkn_ident) {
+		++lexer.tkn_idx;
+		if (lexer.tkn().sv != "phase") {
+		    lexer.parsing_error(lexer.tkn(), "Expected 'phase' or nothing for the amplitude.");
+		    return;
+		}
+		phase = true;
+	    }
+	    success = fft_plot_data(object.obj.plot_data, arg_unary.obj.plot_data, phase);
+	}
+	break;
+    case OP_psd:
+	{
+	    Window_Type window = WINDOW_rect;
+	    if (lexer.tkn(1).type == tkn_ident && lexer.tkn(1).sv == "window") {
+		++lexer.tkn_idx;
+		if (lexer.tkn(1).type != tkn_ident) {
+		    lexer.parsing_error(lexer.tkn(1), "Expected the name of the window.");
+		    return;
+		}
+		++lexer.tkn_idx;
+		window = get_window_type(lexer.tkn().sv);
+		if (window == WINDOW_CNT) {
+		    lexer.parsing_error(lexer.tkn(), "Unknown window, expected 'rect', 'hann', 'hamming' or 'blackman'.");
+		    return;
+		}
+	    }
+	    success = psd_plot_data(object.obj.plot_data, arg_unary.obj.plot_data, window);
+	}
+	break;
+    case OP_conv:
+	success = convolve_plot_data(object.obj.plot_data, arg_unary.obj.plot_data, arg_binary.obj.plot_data);
+	break;
+    case OP_xcorr:
+	success = cross_correlate_plot_data(object.obj.plot_data, arg_unary.obj.plot_data, arg_binary.obj.plot_data);
+	break;
+    }
+
+    if (!success)
+	lexer.parsing_error(op.tkn, "Error occured trying to '%s' the data, perhaps it has too few values.", operator_type_name_table[op.type]);
+}
+
+// data capacity n
+void op_capacity_assign(Lexer &lexer, Command_Object& object, Command_Object& arg_unary)
+{
+    if (object.type != OT_plot_data) {
+	lexer.parsing_error(object.tkn, "Expected data, but got '%s'.", object_type_name_table[object.type]);
+	return;
+    }
+
+    if (arg_unary.type != OT_value || arg_unary.obj.val < 0 || arg_unary.obj.val != std::floor(arg_unary.obj.val)) {
+	lexer.parsing_error(arg_unary.tkn, "Expected the number of values, 0 for no limit.");
+	return;
+    }
+
+    data_manager.set_capacity(object.obj.plot_data, size_t(arg_unary.obj.val));
+}
+
 void execute_assign_operation(Lexer &lexer, Command_Object& object, Command_Operator& op, Command_Object& arg_unary, Command_Object& arg_binary)
 {
     switch(op.type) {
@@ -554,6 +694,15 @@ void execute_assign_operation(Lexer &lexer, Command_Object& object, Command_Oper
     case OP_extrema:
 	op_extrema_assign(lexer, object, op, arg_unary);
 	break;
+    case OP_fft:
+    case OP_psd:
+    case OP_conv:
+    case OP_xcorr:
+	op_spectrum_assign(lexer, object, op, arg_unary, arg_binary);
+	break;
+    case OP_capacity:
+	op_capacity_assign(lexer, object, arg_unary);
+	break;
     }
 }
 
@@ -690,25 +839,36 @@ static bool check_newline(std::string &str, size_t idx)
     return check_and_skip_newline(str, idx);
 }
 
-void re_run_all_commands()
+// A command is tokenized once and its tokens are kept with it. The tokens are the same for every run, only the objects they
+// refer to are looked up again, because reverting recreates the objects.
+static std::shared_ptr<Lexer> get_command_lexer(Command& cmd)
 {
-    for (int64_t i = 0; i <= g_all_commands.get_index(); ++i) {
-	const Command& cmd = g_all_commands.get_commands()[i];
-	
-	Lexer lexer;
-	lexer.get_input() = cmd.cmd;
-	lexer.tokenize();
+    if (!cmd.lexer) {
+	cmd.lexer = std::make_shared<Lexer>();
+	cmd.lexer->get_input() = cmd.cmd;
+	cmd.lexer->tokenize();
+    }
+    cmd.lexer->tkn_idx = 0;
+    return cmd.lexer;
+}
+
+// executes the commands [first_command_idx, current command] again, without adding them to the command list.
+void re_run_commands(int64_t first_command_idx)
+{
+    for (int64_t i = std::max(first_command_idx, int64_t(0)); i <= g_all_commands.get_index(); ++i) {
+	Command& cmd = g_all_commands.get_command(i);
+	std::shared_ptr<Lexer> lexer = get_command_lexer(cmd);
 	
 	if (check_flag(cmd.flags, CF_hidden) || check_flag(cmd.flags, CF_only_on_save)) {
 	    logger.log_info(UTILS_BRIGHT_BLACK "not executed" UTILS_END_COLOR " > ");
-	    for (auto& tkn : lexer.get_tokens()) {
-		lexer.log_token(tkn);
+	    for (auto& tkn : lexer->get_tokens()) {
+		lexer->log_token(tkn);
 	    }
 	    logger.log_info("\n");
 	    continue;
 	}
 		
-	handle_command(lexer, 0, false);
+	handle_command(*lexer, 0, false);
     }
 }
 
@@ -723,17 +883,78 @@ void handle_command_file(std::string file)
 	}
 	cmd = file.substr(i_begin, i - i_begin);
 	check_and_skip_newline(file, i);
-	Lexer lexer;
-	lexer.get_input() = cmd;
-	lexer.tokenize();
-	handle_command(lexer);
+	std::shared_ptr<Lexer> lexer = std::make_shared<Lexer>();
+	lexer->get_input() = cmd;
+	lexer->tokenize();
+	handle_command(*lexer);
+
+	// keep the tokens for running the command again, if it was added to the command list.
+	if (g_all_commands.get_index() >= 0) {
+	    Command& last_cmd = g_all_commands.get_command(g_all_commands.get_index());
+	    if (!last_cmd.lexer && last_cmd.cmd == cmd) {
+		lexer->tkn_idx = 0;
+		last_cmd.lexer = std::move(lexer);
+	    }
+	}
 	++i;
     }
 }
 
+static bool execute_command(Lexer& lexer, int sub_level, bool add_command);
+
+static bool fit_in_background = false; // set for typed commands, the others wait for their fits
+
+// Commands which are added to the command list are timed for the undo checkpoints, a script as a whole.
+// Every command sees the result of the previous fit, only a fit of a typed command keeps running in the background.
 bool handle_command(Lexer& lexer, int sub_level, bool add_command)
+{
+    static bool timing_command = false;
+    if (sub_level > 0 || !add_command || timing_command) {
+	bool success = execute_command(lexer, sub_level, add_command);
+	data_manager.finish_fit();
+	return success;
+    }
+
+    if (lexer.tkn(0).type != tkn_cancel)
+	data_manager.finish_fit();
+    timing_command = true;
+    data_manager.discard_redo_checkpoints();
+    auto time_begin = std::chrono::steady_clock::now();
+    bool success = execute_command(lexer, sub_level, add_command);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - time_begin).count();
+    if (fit_in_background && data_manager.is_fitting()) {
+	data_manager.fit_command_executed(seconds);
+    }
+    else {
+	data_manager.finish_fit();
+	data_manager.command_executed(seconds);
+    }
+    timing_command = false;
+    return success;
+}
+
+bool handle_typed_command(Lexer& lexer)
+{
+    if (data_manager.is_fitting() && lexer.tkn(0).type != tkn_cancel) {
+	logger.log_error("A fit is running, wait for it to finish or 'cancel' it.");
+	return false;
+    }
+    // the command list is cleared, once the file is loaded.
+    if (data_manager.is_loading() && lexer.tkn(0).type != tkn_cancel) {
+	logger.log_error("A file is loading, wait for it to finish or 'cancel' it.");
+	return false;
+    }
+
+    fit_in_background = true;
+    bool success = handle_command(lexer);
+    fit_in_background = false;
+    return success;
+}
+
+static bool execute_command(Lexer& lexer, int sub_level, bool add_command)
 {
     size_t error_cnt = logger.error_cnt;
+    g_frame_dirty = true;
 
     // only log the primary command.
     if (sub_level == 0 && add_command) {
@@ -754,7 +975,7 @@ bool handle_command(Lexer& lexer, int sub_level, bool add_command)
     Command_Object object, arg_unary, arg_binary, arg_tertiary;
     Command_Operator op = get_command_operator(lexer.tkn());
 
-    if (op.type != OP_delete && op.type != OP_export) {
+    if (op.type != OP_delete && op.type != OP_export && op.type != OP_smooth) {
 	auto expand_result = expand_iterators(data_manager, lexer, sub_level);
 	if (expand_result.first) {
 	    return true;
@@ -783,6 +1004,62 @@ bool handle_command(Lexer& lexer, int sub_level, bool add_command)
 	goto exit;
 	
     case OP_smooth:
+	{
+	    Filter filter;
+	    if (lexer.tkn(1).type == tkn_ident) {
+		++lexer.tkn_idx;
+		filter.type = get_filter_type(lexer.tkn().sv);
+		if (filter.type == FILTER_CNT) {
+		    lexer.parsing_error(lexer.tkn(), "Unknown filter, expected 'mean', 'median', 'gauss', 'exp', 'savgol' or 'butter'.");
+		    goto exit;
+		}
+	    }
+	    
+	    arg_unary = expect_command_object(lexer);
+	    if (arg_unary.is_undefined())
+		goto exit;
+
+	    // all data of an iterator are filtered at once, in parallel.
+	    std::vector<Plot_Data*> data_list;
+	    if (arg_unary.type == OT_plot_data) {
+		data_list.push_back(arg_unary.obj.plot_data);
+	    }
+	    else if (arg_unary.type == OT_plot_data_itr) {
+		data_list = *arg_unary.obj.plot_data_itr;
+	    }
+	    else {
+		lexer.parsing_error(lexer.tkn(), "Expected data, but got '%s'.", object_type_name_table[arg_unary.type]);
+		goto exit;
+	    }
+
+	    auto is_number = [&](size_t offset) { return lexer.tkn(offset).type == tkn_int || lexer.tkn(offset).type == tkn_real; };
+	    auto get_number = [&](size_t offset) { return lexer.tkn(offset).type == tkn_int ? double(lexer.tkn(offset).i) : lexer.tkn(offset).d; };
+	    if (!is_number(1)) {
+		lexer.parsing_error(lexer.tkn(1), "Expected the width of the filter.");
+		goto exit;
+	    }
+	    ++lexer.tkn_idx;
+	    filter.width = get_number(0);
+	    filter.order = get_default_filter_order(filter.type);
+	    if (filter.order > 0 && lexer.tkn(1).type == tkn_int) {
+		++lexer.tkn_idx;
+		filter.order = int(lexer.tkn().i);
+	    }
+
+	    size_t min_size = 0;
+	    for (Plot_Data* pd : data_list) {
+		if (pd->size() > 0 && (min_size == 0 || pd->size() < min_size))
+		    min_size = pd->size();
+	    }
+	    if (const char* filter_error = check_filter(filter, min_size)) {
+		lexer.parsing_error(lexer.tkn(), "%s", filter_error);
+		goto exit;
+	    }
+	    if (!smooth_plot_data(data_list, filter))
+		lexer.parsing_error(op.tkn, "Error occured trying to smooth the data, perhaps X or Y were empty.");
+	}
+	goto exit;
+	
     case OP_interp:
 	arg_unary = expect_command_object(lexer);
 	if (arg_unary.is_undefined())
@@ -802,14 +1079,8 @@ bool handle_command(Lexer& lexer, int sub_level, bool add_command)
 	    goto exit;
 	}
 
-	if (op.type == OP_smooth) {
-	    if (!smooth_plot_data(arg_unary.obj.plot_data, arg_binary.tkn.i))
-		lexer.parsing_error(op.tkn, "Error occured trying to smooth the data, perhaps X or Y were empty.");
-	}
-	else if (op.type == OP_interp) {
-	    if (!interp_plot_data(arg_unary.obj.plot_data, arg_binary.tkn.i))
-		lexer.parsing_error(op.tkn, "Error occured trying to interpolate the data, perhaps X or Y were empty.");
-	}
+	if (!interp_plot_data(arg_unary.obj.plot_data, arg_binary.tkn.i))
+	    lexer.parsing_error(op.tkn, "Error occured trying to interpolate the data, perhaps X or Y were empty.");
 	goto exit;
 	
     case OP_show:
@@ -921,13 +1192,15 @@ bool handle_command(Lexer& lexer, int sub_level, bool add_command)
 		    switch(arg_tertiary.type) {
 		    case OT_plot_data:
 			if ((*arg_point_itr)[0] >= 0 && arg_point_itr->back() < int64_t(arg_tertiary.obj.plot_data->size())) {
-			    arg_tertiary.obj.plot_data->y.erase(arg_tertiary.obj.plot_data->y.begin() + (*arg_point_itr)[0],
-								arg_tertiary.obj.plot_data->y.begin() + arg_point_itr->back() + 1);
+			    std::vector<double>& y = arg_tertiary.obj.plot_data->y.edit();
+			    y.erase(y.begin() + (*arg_point_itr)[0], y.begin() + arg_point_itr->back() + 1);
+			    arg_tertiary.obj.plot_data->modified();
 			    if (arg_tertiary.obj.plot_data->x) {
 				
 				Plot_Data* new_x = data_manager.new_plot_data();
 				new_x->y = arg_tertiary.obj.plot_data->x->y;
-			        new_x->y.erase(new_x->y.begin() + (*arg_point_itr)[0], new_x->y.begin() + arg_point_itr->back() + 1);
+				std::vector<double>& x = new_x->y.edit();
+			        x.erase(x.begin() + (*arg_point_itr)[0], x.begin() + arg_point_itr->back() + 1);
 				arg_tertiary.obj.plot_data->x = new_x;
 			    }
 			}
@@ -938,13 +1211,16 @@ bool handle_command(Lexer& lexer, int sub_level, bool add_command)
 		    case OT_plot_data_itr:
 			for (auto pd : *(arg_tertiary.obj.plot_data_itr)) {
 			    if ((*arg_point_itr)[0] >= 0 && arg_point_itr->back() < int64_t(pd->size())) {
-				pd->y.erase(pd->y.begin() + (*arg_point_itr)[0], pd->y.begin() + arg_point_itr->back() + 1);
+				std::vector<double>& y = pd->y.edit();
+				y.erase(y.begin() + (*arg_point_itr)[0], y.begin() + arg_point_itr->back() + 1);
+				pd->modified();
 				
 				if (pd->x) {
 				    // theses cannot the recognized as new objects, but should be fine, since we are also recording errors.
 				    Plot_Data* new_x = data_manager.new_plot_data();
 				    new_x->y = pd->x->y;
-				    new_x->y.erase(new_x->y.begin() + (*arg_point_itr)[0], new_x->y.begin() + arg_point_itr->back() + 1);
+				    std::vector<double>& x = new_x->y.edit();
+				    x.erase(x.begin() + (*arg_point_itr)[0], x.begin() + arg_point_itr->back() + 1);
 				    pd->x = new_x;
 				    
 				    // pd->x->y.erase(pd->x->y.begin() + (*arg_point_itr)[0], pd->x->y.begin() + arg_point_itr->back() + 1);
@@ -972,12 +1248,15 @@ bool handle_command(Lexer& lexer, int sub_level, bool add_command)
 		    switch(arg_tertiary.type) {
 		    case OT_plot_data:
 			if (arg_binary.tkn.i < int64_t(arg_tertiary.obj.plot_data->size())) {
-			    arg_tertiary.obj.plot_data->y.erase(arg_tertiary.obj.plot_data->y.begin() + arg_binary.tkn.i);
+			    std::vector<double>& y = arg_tertiary.obj.plot_data->y.edit();
+			    y.erase(y.begin() + arg_binary.tkn.i);
+			    arg_tertiary.obj.plot_data->modified();
 			    
 			    if (arg_tertiary.obj.plot_data->x) {
 				Plot_Data* new_x = data_manager.new_plot_data();
 				new_x->y = arg_tertiary.obj.plot_data->x->y;
-			        new_x->y.erase(new_x->y.begin() + arg_binary.tkn.i);
+				std::vector<double>& x = new_x->y.edit();
+			        x.erase(x.begin() + arg_binary.tkn.i);
 				arg_tertiary.obj.plot_data->x = new_x;
 				// arg_tertiary.obj.plot_data->x->y.erase(arg_tertiary.obj.plot_data->x->y.begin() + arg_binary.tkn.i);
 			    }
@@ -989,12 +1268,15 @@ bool handle_command(Lexer& lexer, int sub_level, bool add_command)
 		    case OT_plot_data_itr:
 			for (auto pd : *(arg_tertiary.obj.plot_data_itr)) {
 			    if (arg_binary.tkn.i < int64_t(pd->size())) {
-				pd->y.erase(pd->y.begin() + arg_binary.tkn.i);
+				std::vector<double>& y = pd->y.edit();
+				y.erase(y.begin() + arg_binary.tkn.i);
+				pd->modified();
 				
 				if (pd->x) {
 				    Plot_Data* new_x = data_manager.new_plot_data();
 				    new_x->y = pd->x->y;
-				    new_x->y.erase(new_x->y.begin() + arg_binary.tkn.i);
+				    std::vector<double>& x = new_x->y.edit();
+				    x.erase(x.begin() + arg_binary.tkn.i);
 				    pd->x = new_x;
 				    // pd->x->y.erase(pd->x->y.begin() + arg_binary.tkn.i);
 				}
@@ -1033,15 +1315,29 @@ bool handle_command(Lexer& lexer, int sub_level, bool add_command)
 		file_name = lexer.tkn().sv;
 	    }
 
+	    Export_Format format = EF_TEXT;
+	    if (lexer.tkn(1).type == tkn_binary) {
+		++lexer.tkn_idx;
+		format = EF_BINARY;
+		if (lexer.tkn(1).type == tkn_float) {
+		    ++lexer.tkn_idx;
+		    format = EF_BINARY_FLOAT;
+		}
+		if (arg_unary.type != OT_plot_data && arg_unary.type != OT_plot_data_itr) {
+		    lexer.parsing_error(lexer.tkn(), "Only data can be exported in the binary format.");
+		    goto exit;
+		}
+	    }
+
 	    switch (arg_unary.type) {
 	    case OT_plot_data:
 	    {
 		std::vector<Plot_Data*> plot_data {arg_unary.obj.plot_data};
-		data_manager.export_plot_data(file_name, plot_data);
+		data_manager.export_plot_data(file_name, plot_data, format);
 	    }
 	    break;
 	    case OT_plot_data_itr:
-		data_manager.export_plot_data(file_name, *arg_unary.obj.plot_data_itr);
+		data_manager.export_plot_data(file_name, *arg_unary.obj.plot_data_itr, format);
 		break;
 	    case OT_function:
 	    {
@@ -1101,6 +1397,39 @@ bool handle_command(Lexer& lexer, int sub_level, bool add_command)
 	}
 	goto exit;
 
+    case OP_render:
+	{
+	    std::string file_name = DEFAULT_RENDER_FILE_NAME;
+	    if (lexer.tkn(1).type == tkn_string) {
+		++lexer.tkn_idx;
+		file_name = lexer.tkn().sv;
+	    }
+
+	    // the size of the window by default
+	    int width = get_plot_width() > 0 ? get_plot_width() : SCREEN_WIDTH;
+	    int height = get_plot_height() > 0 ? get_plot_height() : SCREEN_HEIGHT;
+	    if (lexer.tkn(1).type == tkn_int) {
+		if (lexer.tkn(2).type != tkn_int) {
+		    lexer.parsing_error(lexer.tkn(2), "Expected the height of the image.");
+		    goto exit;
+		}
+		// checked before the cast to int, which would truncate
+		int64_t width_value = lexer.tkn(1).i;
+		int64_t height_value = lexer.tkn(2).i;
+		lexer.tkn_idx += 2;
+		if (width_value <= 0 || height_value <= 0 || width_value > MAX_RENDER_SIZE || height_value > MAX_RENDER_SIZE) {
+		    lexer.parsing_error(lexer.tkn(), "The size of the image must be between 1 and %d.", MAX_RENDER_SIZE);
+		    goto exit;
+		}
+		width = int(width_value);
+		height = int(height_value);
+	    }
+
+	    render_plot_image(file_name, width, height);
+	    g_all_commands.add_cmd_flag(CF_only_on_save);
+	}
+	goto exit;
+
     case OP_zero:
 	data_manager.zero_coord_sys_origin();
 	goto exit;
@@ -1108,6 +1437,72 @@ bool handle_command(Lexer& lexer, int sub_level, bool add_command)
     case OP_help:
 	logger.log_help_message();
 	goto exit;
+
+    case OP_cancel:
+	if (sub_level == 0 && add_command) {
+	    g_all_commands.pop(); // canceling does not belong into the script
+	}
+	if (!data_manager.is_loading() && !data_manager.is_fitting()) {
+	    lexer.parsing_error(op.tkn, "There is nothing to cancel.");
+	    goto exit;
+	}
+	data_manager.cancel_fit();
+	data_manager.cancel_loading();
+	goto exit;
+
+    case OP_bench:
+	if (sub_level == 0 && add_command) {
+	    g_all_commands.pop(); // benchmarks do not belong into the script
+	}
+	arg_unary = expect_command_object(lexer);
+	if (arg_unary.is_undefined())
+	    goto exit;
+	if (arg_unary.type != OT_function) {
+	    lexer.parsing_error(arg_unary.tkn, "Expected a function.");
+	    goto exit;
+	}
+	benchmark_function(arg_unary.obj.function);
+	goto exit;
+
+    case OP_bound:
+	{
+	    // the function is parsed here, because 'function 0 c' would be the value of the parameter.
+	    if (lexer.tkn(1).type != tkn_function || lexer.tkn(2).type != tkn_int || lexer.tkn(3).type != tkn_ident) {
+		lexer.parsing_error(lexer.tkn(1), "Expected a function and one of its parameters.");
+		goto exit;
+	    }
+	    if (lexer.tkn(2).i < 0 || lexer.tkn(2).i >= int64_t(data_manager.functions.size())) {
+		lexer.parsing_error(lexer.tkn(2), "The function with index '%d' does not exist.", lexer.tkn(2).i);
+		goto exit;
+	    }
+	    Function* function = data_manager.functions[lexer.tkn(2).i];
+	    int param_idx = function->get_parameter_idx(lexer.tkn(3).sv);
+	    if (param_idx < 0) {
+		lexer.parsing_error(lexer.tkn(3), "This parameter does not exist.");
+		goto exit;
+	    }
+	    lexer.tkn_idx += 3;
+
+	    // without limits the parameter is unbounded again
+	    Parameter_Bounds bounds;
+	    auto is_number = [&](size_t offset) { return lexer.tkn(offset).type == tkn_int || lexer.tkn(offset).type == tkn_real; };
+	    auto get_number = [&](size_t offset) { return lexer.tkn(offset).type == tkn_int ? double(lexer.tkn(offset).i) : lexer.tkn(offset).d; };
+	    if (is_number(1)) {
+		if (!is_number(2)) {
+		    lexer.parsing_error(lexer.tkn(2), "Expected the upper limit.");
+		    goto exit;
+		}
+		bounds.lower = get_number(1);
+		bounds.upper = get_number(2);
+		if (bounds.lower > bounds.upper) {
+		    lexer.parsing_error(lexer.tkn(1), "The lower limit is greater than the upper limit.");
+		    goto exit;
+		}
+		lexer.tkn_idx += 2;
+	    }
+	    function->set_parameter_bounds(param_idx, bounds);
+	}
+	goto exit;
 	
     case OP_fit:
 	arg_unary = expect_command_object(lexer);
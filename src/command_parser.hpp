@@ -39,6 +39,8 @@ struct Command_Object
     Object_Type type = OT_undefined;
     Token tkn;
     bool new_object = false;
+    Plot_Data* value_owner = nullptr; // the data which val_ptr points into, if any.
+    size_t value_idx = 0;             // the index of val_ptr in value_owner.
     union {
 	Plot_Data* plot_data;
 	Plot_Data** plot_data_ptr;
@@ -59,6 +61,15 @@ struct Command_Object
     }
     
     void delete_new_object();
+    // writes through val_ptr. Values of data are written with edit_window, since the data can be a read only view.
+    void set_value(double value)
+    {
+	if (value_owner)
+	    obj.val_ptr = &value_owner->y.edit_window()[value_idx];
+	*obj.val_ptr = value;
+	if (value_owner)
+	    value_owner->modified();
+    }
 
     bool is_undefined() { return type == OT_undefined; }
 };
@@ -88,6 +99,15 @@ enum Operator_Type
     OP_zero,
     OP_help,
     OP_new,
+    OP_cancel,
+    OP_bench,
+    OP_bound,
+    OP_fft,
+    OP_psd,
+    OP_conv,
+    OP_xcorr,
+    OP_capacity,
+    OP_render,
     OP_SIZE,
 };
 
@@ -115,6 +135,15 @@ inline const char *operator_type_name_table[OP_SIZE] {
     "zero",
     "help",
     "new",
+    "cancel",
+    "bench",
+    "bound",
+    "fft",
+    "psd",
+    "conv",
+    "xcorr",
+    "capacity",
+    "render",
 };
 
 inline int op_arg_cnt_table[OP_SIZE] {
@@ -141,6 +170,15 @@ inline int op_arg_cnt_table[OP_SIZE] {
     0,
     0,
     1,
+    0,
+    1,
+    0,
+    1,
+    1,
+    2,
+    2,
+    1,
+    0,
 };
 
 struct Command_Operator
@@ -153,5 +191,7 @@ struct Command_Operator
 // command structure:
 // object (to be changed or created) = operator (+,-,fit) object_A (unary) object_B (binary)
 bool handle_command(Lexer &lexer, int sub_level = 0, bool add_command = true);
+// for the text input, a fit started by the command runs in the background.
+bool handle_typed_command(Lexer &lexer);
 void handle_command_file(std::string file);
-void re_run_all_commands();
+void re_run_commands(int64_t first_command_idx);
@@ -0,0 +1,355 @@
+#include "csv_parser.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "data_manager.hpp"
+#include "global_vars.hpp"
+#include "utils.hpp"
+
+// The file is split into this many bytes per thread at least, smaller files are parsed on one thread.
+constexpr size_t CSV_MIN_CHUNK_SIZE = 1 << 20;
+// The background loader parses blocks of this many bytes per thread.
+constexpr size_t CSV_LOADER_CHUNK_SIZE = 4 << 20;
+constexpr size_t CSV_MAX_NUMBER_LENGTH = 64;
+
+struct Csv_Chunk
+{
+    const char* begin;
+    const char* end;
+    Csv_Block block;
+    size_t out_of_range_cnt = 0;
+};
+
+static bool is_whitespace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\t' || c == '\f' || c == '\r' || c == '\v';
+}
+
+static bool is_new_line(char c)
+{
+    return c == '\n' || c == '\f' || c == '\r';
+}
+
+static bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static bool is_alpha(char c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+}
+
+// inside a string a comma is a decimal point (fixing , notation in numbers).
+static bool is_number_begin(const char* p, const char* p_end, bool inside_string)
+{
+    if (is_digit(*p))
+	return true;
+    bool sign_or_point = *p == '.' || *p == '+' || *p == '-' || (inside_string && *p == ',');
+    return sign_or_point && p + 1 < p_end && is_digit(p[1]);
+}
+
+// Parses a single number locale independently and returns the end of it.
+// std::from_chars accepts neither a leading '+', nor a decimal comma, so numbers in a string are copied and fixed up first.
+static const char* parse_number(const char* p, const char* p_end, bool inside_string, double& value, Csv_Chunk& chunk)
+{
+    char buffer[CSV_MAX_NUMBER_LENGTH + 1];
+    const char* begin = p;
+    const char* end = p_end;
+
+    if (inside_string) {
+	size_t n = 0;
+	for (const char* q = p; q < p_end && n < CSV_MAX_NUMBER_LENGTH; ++q, ++n) {
+	    bool sign = (*q == '+' || *q == '-') && (q == p || q[-1] == 'e' || q[-1] == 'E');
+	    if (!(is_digit(*q) || *q == '.' || *q == ',' || is_alpha(*q) || sign))
+		break;
+	    buffer[n] = *q == ',' ? '.' : *q;
+	}
+	begin = buffer;
+	end = buffer + n;
+    }
+
+    const char* number = begin + (*begin == '+');
+    auto result = std::from_chars(number, end, value);
+
+    if (result.ec == std::errc::result_out_of_range) {
+	// rare, let strtod decide between infinity and zero.
+	std::string str(number, result.ptr);
+	value = std::strtod(str.c_str(), nullptr);
+	++chunk.out_of_range_cnt;
+    }
+    else if (result.ec != std::errc()) {
+	value = 0;
+	return p + 1;
+    }
+    return p + (result.ptr - begin);
+}
+
+// Parses a number or a time code hh:mm:ss.mmm, which is converted to seconds.
+static const char* parse_value(const char* p, const char* p_end, bool inside_string, double& value, Csv_Chunk& chunk)
+{
+    p = parse_number(p, p_end, inside_string, value, chunk);
+
+    if (p < p_end && *p == ':') {
+	double minutes = 0;
+	double seconds = 0;
+	p = parse_number(p + 1, p_end, inside_string, minutes, chunk);
+	if (p < p_end && *p == ':')
+	    p = parse_number(p + 1, p_end, inside_string, seconds, chunk);
+	value = value * 60 * 60 + minutes * 60 + seconds;
+    }
+    return p;
+}
+
+// Chunks always begin at the start of a line. Strings (quotes) are expected to end on the same line.
+static void parse_csv_chunk(Csv_Chunk& chunk)
+{
+    const char* p = chunk.begin;
+    const char* p_end = chunk.end;
+
+    size_t data_column = 0;
+    bool inside_string = false;
+
+    auto get_column = [&]() -> std::vector<double>& {
+	while (chunk.block.columns.size() <= data_column) {
+	    chunk.block.columns.emplace_back();
+	    chunk.block.headers.emplace_back();
+	}
+	return chunk.block.columns[data_column];
+    };
+    get_column();
+
+    while (p < p_end)
+    {
+	const char* prev_p = p;
+
+	while (p < p_end && is_whitespace(*p)) {
+	    if (is_new_line(*p))
+		data_column = 0;
+	    ++p;
+	}
+
+	if (p < p_end && *p == '\"') {
+	    inside_string = !inside_string;
+	    ++p;
+	}
+
+	if (p < p_end && *p == '#') {
+	    while (p < p_end && *p != '\n') {
+		++p;
+	    }
+	}
+
+	if (p < p_end && is_number_begin(p, p_end, inside_string)) {
+	    double value;
+	    p = parse_value(p, p_end, inside_string, value, chunk);
+	    get_column().push_back(value);
+	}
+
+	if (p < p_end && *p == ',' && !inside_string) {
+	    ++data_column;
+	    get_column();
+	    ++p;
+	}
+
+	// header
+	if (p < p_end && p == prev_p && inside_string) {
+	    const char* begin = p;
+	    while (p < p_end && *p != '\"') {
+		++p;
+	    }
+	    std::string header(begin, p - begin);
+	    std::replace(header.begin(), header.end(), ',', '.');
+	    get_column();
+	    chunk.block.headers[data_column] += header;
+	    inside_string = false;
+	    ++p;
+	}
+
+	// skip anything else
+	if (p == prev_p) {
+	    ++p;
+	}
+    }
+}
+
+static void run_parallel(size_t cnt, const std::function<void(size_t)>& func)
+{
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < cnt; ++i)
+	threads.emplace_back(func, i);
+    func(0);
+    for (auto& thread : threads)
+	thread.join();
+}
+
+// Splits [begin, end) at line boundaries into one chunk per thread (of at least chunk_size bytes) and parses them in parallel.
+static std::vector<Csv_Chunk> parse_csv_parallel(const char* begin, const char* end, size_t chunk_size)
+{
+    size_t size = end - begin;
+    size_t thread_cnt = std::max(size_t(1), std::min(size_t(std::thread::hardware_concurrency()), size / chunk_size));
+    std::vector<Csv_Chunk> chunks(thread_cnt);
+
+    const char* chunk_begin = begin;
+    for (size_t i = 0; i < thread_cnt; ++i) {
+	const char* chunk_end = end;
+	if (i + 1 < thread_cnt) {
+	    chunk_end = std::max(chunk_begin, begin + size / thread_cnt * (i + 1));
+	    while (chunk_end < end && *chunk_end != '\n')
+		++chunk_end;
+	}
+	chunks[i].begin = chunk_begin;
+	chunks[i].end = chunk_end;
+	chunk_begin = chunk_end;
+    }
+
+    run_parallel(chunks.size(), [&](size_t i) { parse_csv_chunk(chunks[i]); });
+    return chunks;
+}
+
+static void log_out_of_range(const std::vector<Csv_Chunk>& chunks)
+{
+    size_t out_of_range_cnt = 0;
+    for (const auto& chunk : chunks)
+	out_of_range_cnt += chunk.out_of_range_cnt;
+    if (out_of_range_cnt > 0)
+	logger.log_info("%zu parsed numbers were out of range.\n", out_of_range_cnt);
+}
+
+// The file is memory mapped and split at line boundaries into one chunk per thread. Every chunk is parsed into its own columns,
+// which are then copied in parallel into the pre-sized columns of the plot data.
+std::vector<Plot_Data*> parse_numeric_csv_file(const std::string& file_name)
+{
+    auto time_begin = std::chrono::steady_clock::now();
+
+    Mapped_File file;
+    if (!file.open(file_name)) {
+	logger.log_error("Failed to open file '%s'.", file_name.c_str());
+	return {};
+    }
+    if (file.size() == 0) {
+	return {};
+    }
+
+    std::vector<Csv_Chunk> chunks = parse_csv_parallel(file.data(), file.data() + file.size(), CSV_MIN_CHUNK_SIZE);
+
+    // merge the chunks
+    size_t column_cnt = 0;
+    for (const auto& chunk : chunks)
+	column_cnt = std::max(column_cnt, chunk.block.columns.size());
+
+    std::vector<Plot_Data*> data_list(column_cnt);
+    std::vector<double*> values(column_cnt);
+    std::vector<std::vector<size_t>> offsets(chunks.size(), std::vector<size_t>(column_cnt, 0));
+
+    for (size_t c = 0; c < column_cnt; ++c) {
+	data_list[c] = new Plot_Data;
+	size_t size = 0;
+	for (size_t i = 0; i < chunks.size(); ++i) {
+	    offsets[i][c] = size;
+	    if (c < chunks[i].block.columns.size()) {
+		size += chunks[i].block.columns[c].size();
+		data_list[c]->info.header += chunks[i].block.headers[c];
+	    }
+	}
+	std::vector<double>& y = data_list[c]->y.edit();
+	y.resize(size);
+	values[c] = y.data();
+    }
+
+    run_parallel(chunks.size(), [&](size_t i) {
+	std::vector<std::vector<double>>& columns = chunks[i].block.columns;
+	for (size_t c = 0; c < columns.size(); ++c) {
+	    std::copy(columns[c].begin(), columns[c].end(), values[c] + offsets[i][c]);
+	    columns[c] = {};
+	}
+    });
+
+    log_out_of_range(chunks);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - time_begin).count();
+    logger.log_info("Parsed '%s' (%.1f MB) in %.3f s on %zu threads, %.2f GB/s.\n", file_name.c_str(), double(file.size()) / 1e6, seconds,
+		    chunks.size(), double(file.size()) / 1e9 / std::max(seconds, 1e-9));
+
+    return data_list;
+}
+
+bool Csv_Loader::start(const std::string& file_name)
+{
+    cancel();
+    if (!file.open(file_name))
+	return false;
+
+    this->file_name = file_name;
+    parsed_blocks.clear();
+    bytes_parsed = 0;
+    cancel_requested = false;
+    finished = false;
+    active = true;
+    thread = std::thread(&Csv_Loader::run, this);
+    return true;
+}
+
+void Csv_Loader::cancel()
+{
+    cancel_requested = true;
+    if (thread.joinable())
+	thread.join();
+}
+
+bool Csv_Loader::take_blocks(std::vector<Csv_Block>& blocks)
+{
+    if (!active)
+	return false;
+
+    bool loading_finished = finished; // read before taking, so no block can be missed
+    {
+	std::lock_guard<std::mutex> lock(mutex);
+	for (auto& block : parsed_blocks)
+	    blocks.push_back(std::move(block));
+	parsed_blocks.clear();
+    }
+
+    if (loading_finished) {
+	if (thread.joinable())
+	    thread.join();
+	file.close();
+	active = false;
+    }
+    return true;
+}
+
+void Csv_Loader::run()
+{
+    auto time_begin = std::chrono::steady_clock::now();
+    const char* p = file.data();
+    const char* p_end = p + file.size();
+    size_t block_size = CSV_LOADER_CHUNK_SIZE * std::max(1u, std::thread::hardware_concurrency());
+
+    while (p < p_end && !cancel_requested)
+    {
+	const char* block_end = p + std::min(block_size, size_t(p_end - p));
+	while (block_end < p_end && *block_end != '\n')
+	    ++block_end;
+
+	std::vector<Csv_Chunk> chunks = parse_csv_parallel(p, block_end, CSV_MIN_CHUNK_SIZE);
+	log_out_of_range(chunks);
+	{
+	    std::lock_guard<std::mutex> lock(mutex);
+	    for (auto& chunk : chunks)
+		parsed_blocks.push_back(std::move(chunk.block));
+	}
+	p = block_end;
+	bytes_parsed = p - file.data();
+    }
+
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - time_begin).count();
+    finished = true;
+}
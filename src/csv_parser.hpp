@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mapped_file.hpp"
+
+// Values and headers of consecutive rows of a csv file, by column.
+struct Csv_Block
+{
+    std::vector<std::vector<double>> columns;
+    std::vector<std::string> headers;
+};
+
+// Parses a csv file on a background thread, block by block, so the data can be shown while it is loading.
+// Finished blocks are handed over in file order with take_blocks.
+struct Csv_Loader
+{
+    Csv_Loader() {}
+    Csv_Loader(const Csv_Loader&) = delete;
+    Csv_Loader& operator=(const Csv_Loader&) = delete;
+    ~Csv_Loader() { cancel(); }
+
+    // returns false, if the file could not be opened.
+    bool start(const std::string& file_name);
+    // stops the loading after the current block, blocks which are already parsed can still be taken.
+    void cancel();
+
+    // moves the blocks parsed since the last call to blocks. Returns false, once all blocks were taken after the loading ended.
+    bool take_blocks(std::vector<Csv_Block>& blocks);
+
+    bool is_active() const { return active; }
+    bool was_canceled() const { return cancel_requested; }
+    double get_progress() const { return file.size() == 0 ? 1.0 : double(bytes_parsed) / double(file.size()); }
+    size_t get_bytes_parsed() const { return bytes_parsed; }
+    const std::string& get_file_name() const { return file_name; }
+    double get_seconds() const { return seconds; } // duration of the parsing, once finished
+
+private:
+
+    void run();
+
+    std::string file_name;
+    Mapped_File file;
+    std::thread thread;
+    std::mutex mutex;
+    std::vector<Csv_Block> parsed_blocks;
+    std::atomic<size_t> bytes_parsed = 0;
+    std::atomic<bool> cancel_requested = false;
+    std::atomic<bool> finished = false;
+    std::atomic<double> seconds = 0;
+    bool active = false;
+};
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+// The values of a Plot_Data. Copies share the same immutable buffer, which is reference counted, so copying data
+// (undo checkpoints, duplicated X data) costs nothing until one of the copies is changed.
+// The buffer is either owned, or a read only view into memory which is owned by something else, e.g. a memory mapped
+// PLOT_FILE_EXTENSION file, and kept alive by view_owner as long as the view exists. Reading never copies, so a mapped
+// file is only paged in where it is read. Every change goes through edit(), which first copies a shared buffer or a view
+// into a buffer of its own (copy on write).
+// With a capacity, only the last capacity values are kept (a rolling window). The buffer holds up to twice the capacity,
+// the window starts at an offset into it and is moved to the front only when the buffer is full, so appending is O(1)
+// amortized without reallocating, and the values are still contiguous for reading.
+// A column is only changed on the main thread. Other threads (e.g. the Fit_Worker) read copies of their own, which they
+// may release at any time.
+struct Data_Column
+{
+    Data_Column() {}
+    Data_Column(std::vector<double> new_values) { *this = std::move(new_values); }
+
+    Data_Column& operator=(std::vector<double> new_values)
+    {
+	values = std::make_shared<std::vector<double>>(std::move(new_values));
+	offset = 0;
+	release_view();
+	if (capacity > 0 && values->size() > capacity)
+	    offset = values->size() - capacity;
+	return *this;
+    }
+
+    // ptr has to stay valid and unchanged, as long as owner is alive.
+    static Data_Column view(std::shared_ptr<const void> owner, const double* ptr, size_t size)
+    {
+	Data_Column column;
+	if (size > 0) {
+	    column.view_owner = std::move(owner);
+	    column.view_ptr = ptr;
+	    column.view_size = size;
+	}
+	return column;
+    }
+
+    size_t size() const { return view_owner ? view_size : values ? values->size() - offset : 0; }
+    bool empty() const { return size() == 0; }
+    const double* data() const { return view_owner ? view_ptr : values ? values->data() + offset : nullptr; }
+    const double& operator[](size_t idx) const { return data()[idx]; }
+    const double& back() const { return data()[size() - 1]; }
+    const double* begin() const { return data(); }
+    const double* end() const { return data() + size(); }
+    bool is_view() const { return bool(view_owner); }
+
+    // identifies the owned buffer (shared between copies) for counting memory, nullptr for views.
+    const void* get_owned_buffer() const { return view_owner ? nullptr : values.get(); }
+
+    // the values for changing them, a view or a buffer which is shared with other copies is copied first.
+    // The window of a column with a capacity is moved to the front of the buffer, the capacity is applied by the next append.
+    // Use edit_window for changing values without changing the size.
+    std::vector<double>& edit()
+    {
+	if (!is_unique_buffer()) {
+	    make_unique_buffer();
+	}
+	else if (offset > 0) {
+	    values->erase(values->begin(), values->begin() + offset);
+	    offset = 0;
+	}
+	return *values;
+    }
+
+    // the values of the window for changing them in place. Unlike edit, the window is not moved, so changing single values
+    // of a rolling window stays O(1).
+    std::span<double> edit_window()
+    {
+	if (!is_unique_buffer())
+	    make_unique_buffer();
+	return std::span<double>(values->data() + offset, values->size() - offset);
+    }
+
+    // returns true, if values were dropped from the front because of the capacity.
+    bool append(std::span<const double> new_values)
+    {
+	if (!is_unique_buffer())
+	    make_unique_buffer();
+
+	if (capacity == 0) {
+	    values->insert(values->end(), new_values.begin(), new_values.end());
+	    return false;
+	}
+
+	size_t old_size = size();
+	if (new_values.size() >= capacity) {
+	    values->assign(new_values.end() - capacity, new_values.end());
+	    offset = 0;
+	}
+	else {
+	    if (values->size() + new_values.size() > 2 * capacity) {
+		values->erase(values->begin(), values->begin() + offset);
+		offset = 0;
+	    }
+	    values->insert(values->end(), new_values.begin(), new_values.end());
+	    if (values->size() - offset > capacity)
+		offset = values->size() - capacity;
+	}
+	first_idx += old_size + new_values.size() - size();
+	return size() < old_size + new_values.size();
+    }
+
+    // 0 for no limit. Returns true, if values were dropped from the front.
+    bool set_capacity(size_t new_capacity)
+    {
+	capacity = new_capacity;
+	if (capacity == 0)
+	    return false;
+	size_t old_size = size();
+	std::vector<double>& buffer = edit();
+	if (buffer.size() > capacity)
+	    buffer.erase(buffer.begin(), buffer.end() - capacity);
+	buffer.reserve(2 * capacity);
+	first_idx += old_size - size();
+	return size() < old_size;
+    }
+
+    // drops the values in front of the window, after changing the values through edit().
+    bool apply_capacity() { return set_capacity(capacity); }
+
+    size_t get_capacity() const { return capacity; }
+
+    // the number of values which were dropped from the front of the window, so value idx is the (get_first_index() + idx)th
+    // value since the column was created. Cached representations of a rolling window index by it, so they are moved
+    // along with the window instead of being rebuilt.
+    size_t get_first_index() const { return first_idx; }
+
+private:
+
+    // The buffer can be changed in place, if no other copy shares it. The last other copy may have been released on
+    // another thread: use_count is only a relaxed load, the fence orders the reads of that thread before the changes.
+    bool is_unique_buffer() const
+    {
+	if (view_owner || !values || values.use_count() > 1)
+	    return false;
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return true;
+    }
+
+    // copies the window into a buffer of its own, with room for twice the capacity.
+    void make_unique_buffer()
+    {
+	auto new_values = std::make_shared<std::vector<double>>();
+	new_values->reserve(std::max(2 * capacity, size()));
+	new_values->assign(data(), data() + size());
+	values = std::move(new_values);
+	offset = 0;
+	release_view();
+    }
+
+    void release_view()
+    {
+	view_owner.reset();
+	view_ptr = nullptr;
+	view_size = 0;
+    }
+
+    std::shared_ptr<std::vector<double>> values;
+    std::shared_ptr<const void> view_owner;
+    const double* view_ptr = nullptr;
+    size_t view_size = 0;
+    size_t offset = 0;   // of the window in values
+    size_t capacity = 0; // 0 for no limit
+    size_t first_idx = 0; // see get_first_index
+};
@@ -0,0 +1,369 @@
+#include "data_filters.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "utils.hpp"
+
+constexpr double FILTER_MAX_WIDTH = 1e9;
+constexpr int FILTER_MAX_SAVGOL_ORDER = 10;
+constexpr int FILTER_MAX_BUTTER_ORDER = 10;
+constexpr double FILTER_MIN_BOX_GAUSS_SIGMA = 3;
+
+Filter_Type get_filter_type(std::string_view name)
+{
+    for (int type = 0; type < FILTER_CNT; ++type) {
+	if (name == filter_name_table[type])
+	    return Filter_Type(type);
+    }
+    return FILTER_CNT;
+}
+
+int get_default_filter_order(Filter_Type type)
+{
+    switch (type) {
+    case FILTER_savgol: return 2;
+    case FILTER_butter: return 2;
+    default: return 0;
+    }
+}
+
+const char* check_filter(const Filter& filter, size_t size)
+{
+    switch (filter.type) {
+    case FILTER_mean:
+    case FILTER_median:
+	if (filter.width < 0 || filter.width > FILTER_MAX_WIDTH || filter.width != std::floor(filter.width))
+	    return "The window size has to be a positive integer.";
+	break;
+    case FILTER_gauss:
+    case FILTER_exp:
+	if (!(filter.width > 0 && filter.width <= FILTER_MAX_WIDTH))
+	    return "The width has to be greater than 0.";
+	break;
+    case FILTER_savgol:
+	if (filter.width < 1 || filter.width > FILTER_MAX_WIDTH || filter.width != std::floor(filter.width))
+	    return "The window size has to be an integer greater than 0.";
+	if (size > 0 && 2 * filter.width + 1 > double(size))
+	    return "The window of 2 * width + 1 samples can not be larger than the data.";
+	if (filter.order < 0 || filter.order > FILTER_MAX_SAVGOL_ORDER || filter.order > 2 * filter.width)
+	    return "The order has to be between 0 and 10, and less than the number of samples in the window.";
+	break;
+    case FILTER_butter:
+	if (!(filter.width > 0 && filter.width < 0.5))
+	    return "The cutoff frequency has to be between 0 and 0.5 (the Nyquist frequency).";
+	if (filter.order < 1 || filter.order > FILTER_MAX_BUTTER_ORDER)
+	    return "The order has to be between 1 and 10.";
+	break;
+    default:
+	return "Unknown filter.";
+    }
+    return nullptr;
+}
+
+// the value at idx, continued by the first and last value outside of the data.
+static inline double get_clamped(const double* y, size_t n, int64_t idx)
+{
+    return y[std::clamp(idx, int64_t(0), int64_t(n) - 1)];
+}
+
+// A running sum, which is compensated so the error does not grow with the number of samples.
+// Values which are not finite are counted instead, the average of a window with one of them is NaN.
+static void moving_average(const double* y, size_t n, int64_t width, double* filtered)
+{
+    Kahan_Sum sum;
+    int64_t non_finite_cnt = 0;
+    auto add = [&](double value, double factor) {
+	if (std::isfinite(value))
+	    sum.add(factor * value);
+	else
+	    non_finite_cnt += int64_t(factor);
+    };
+
+    add(y[0], double(width));
+    for (int64_t k = 0; k <= std::min(width, int64_t(n) - 1); ++k)
+	add(y[k], 1);
+    if (width > int64_t(n) - 1)
+	add(y[n - 1], double(width - (int64_t(n) - 1)));
+
+    double scale = 1.0 / double(2 * width + 1);
+    for (int64_t i = 0; i < int64_t(n); ++i) {
+	filtered[i] = non_finite_cnt > 0 ? NAN : sum.get() * scale;
+	add(get_clamped(y, n, i + width + 1), 1);
+	add(get_clamped(y, n, i - width), -1);
+    }
+}
+
+// NaN is sorted after all other values, so the order stays strict.
+struct Nan_Last_Less
+{
+    bool operator()(double a, double b) const { return a < b || (!std::isnan(a) && std::isnan(b)); }
+};
+
+// The window is split into its lower and upper half, the median is the largest value of the lower half.
+// Equal values are counted, so the repeated first and last values of a window wider than the data are only stored once.
+static void moving_median(const double* y, size_t n, int64_t width, double* filtered)
+{
+    using Half = std::map<double, int64_t, Nan_Last_Less>; // value -> count
+    Half lower;
+    Half upper;
+    int64_t lower_cnt = 0, upper_cnt = 0;
+    Nan_Last_Less less;
+
+    auto move = [](Half& from, Half::iterator it, int64_t cnt, Half& to) {
+	to[it->first] += cnt;
+	if ((it->second -= cnt) == 0)
+	    from.erase(it);
+    };
+    auto balance = [&]() {
+	while (lower_cnt > upper_cnt + 1) {
+	    int64_t cnt = std::min(std::prev(lower.end())->second, (lower_cnt - upper_cnt) / 2);
+	    move(lower, std::prev(lower.end()), cnt, upper);
+	    lower_cnt -= cnt;
+	    upper_cnt += cnt;
+	}
+	while (upper_cnt > lower_cnt) {
+	    int64_t cnt = std::min(upper.begin()->second, (upper_cnt - lower_cnt + 1) / 2);
+	    move(upper, upper.begin(), cnt, lower);
+	    upper_cnt -= cnt;
+	    lower_cnt += cnt;
+	}
+    };
+    auto insert = [&](double value, int64_t cnt) {
+	if (lower.empty() || !less(lower.rbegin()->first, value)) {
+	    lower[value] += cnt;
+	    lower_cnt += cnt;
+	}
+	else {
+	    upper[value] += cnt;
+	    upper_cnt += cnt;
+	}
+	balance();
+    };
+    auto erase = [&](double value) {
+	bool in_lower = !less(lower.rbegin()->first, value);
+	auto& half = in_lower ? lower : upper;
+	auto it = half.find(value);
+	if (--it->second == 0)
+	    half.erase(it);
+	--(in_lower ? lower_cnt : upper_cnt);
+	balance();
+    };
+
+    const int64_t last = int64_t(n) - 1;
+    insert(y[0], width + 1);
+    for (int64_t k = 1; k <= std::min(width, last); ++k)
+	insert(y[k], 1);
+    if (width > last)
+	insert(y[last], width - last);
+    for (int64_t i = 0; i < int64_t(n); ++i) {
+	filtered[i] = lower.rbegin()->first;
+	insert(get_clamped(y, n, i + width + 1), 1);
+	erase(get_clamped(y, n, i - width));
+    }
+}
+
+// Three moving averages, their widths are chosen for the standard deviation sigma (W. M. Wells, 1986).
+// Too few samples are averaged for a small sigma, then the kernel is applied directly, cut off at 4 sigma.
+static void gaussian(const double* y, size_t n, double sigma, double* filtered)
+{
+    if (sigma < FILTER_MIN_BOX_GAUSS_SIGMA) {
+	int64_t width = int64_t(std::ceil(4 * sigma));
+	std::vector<double> weights(2 * width + 1);
+	double weight_sum = 0;
+	for (int64_t k = -width; k <= width; ++k) {
+	    weights[k + width] = std::exp(-double(k * k) / (2 * sigma * sigma));
+	    weight_sum += weights[k + width];
+	}
+	for (int64_t i = 0; i < int64_t(n); ++i) {
+	    double sum = 0;
+	    for (int64_t k = -width; k <= width; ++k)
+		sum += weights[k + width] * get_clamped(y, n, i + k);
+	    filtered[i] = sum / weight_sum;
+	}
+	return;
+    }
+    
+    constexpr int pass_cnt = 3;
+    int lower_size = int(std::sqrt(12.0 * sigma * sigma / pass_cnt + 1));
+    if (lower_size % 2 == 0)
+	--lower_size;
+    int lower_cnt = int(std::round((12.0 * sigma * sigma - pass_cnt * lower_size * lower_size - 4.0 * pass_cnt * lower_size - 3.0 * pass_cnt)
+				   / (-4.0 * lower_size - 4.0)));
+    int64_t widths[pass_cnt];
+    for (int i = 0; i < pass_cnt; ++i)
+	widths[i] = ((i < lower_cnt ? lower_size : lower_size + 2) - 1) / 2;
+
+    std::vector<double> temp(n);
+    moving_average(y, n, widths[0], filtered);
+    moving_average(filtered, n, widths[1], temp.data());
+    moving_average(temp.data(), n, widths[2], filtered);
+}
+
+static void exponential(const double* y, size_t n, double time_constant, double* filtered)
+{
+    double alpha = 1 - std::exp(-1 / time_constant);
+    filtered[0] = y[0];
+    for (size_t i = 1; i < n; ++i)
+	filtered[i] = filtered[i - 1] + alpha * (y[i] - filtered[i - 1]);
+}
+
+// The weights of the samples in the window, for the value of the least squares polynomial in the center of the window.
+// The polynomial is in k / width, to keep the normal equations well conditioned.
+static std::vector<double> get_savitzky_golay_weights(int64_t width, int order)
+{
+    const int m = order + 1;
+    std::vector<double> moments(2 * m - 1, 0.0);
+    for (int64_t k = -width; k <= width; ++k) {
+	double t = double(k) / double(width);
+	double power = 1;
+	for (auto& moment : moments) {
+	    moment += power;
+	    power *= t;
+	}
+    }
+
+    // solves moments[i + j] * z = e_0 by gaussian elimination
+    std::vector<double> a(m * m);
+    std::vector<double> z(m, 0.0);
+    z[0] = 1;
+    for (int i = 0; i < m; ++i)
+	for (int j = 0; j < m; ++j)
+	    a[i * m + j] = moments[i + j];
+    for (int col = 0; col < m; ++col) {
+	int pivot = col;
+	for (int row = col + 1; row < m; ++row)
+	    if (std::abs(a[row * m + col]) > std::abs(a[pivot * m + col]))
+		pivot = row;
+	for (int j = 0; j < m; ++j)
+	    std::swap(a[col * m + j], a[pivot * m + j]);
+	std::swap(z[col], z[pivot]);
+	for (int row = col + 1; row < m; ++row) {
+	    double factor = a[row * m + col] / a[col * m + col];
+	    for (int j = col; j < m; ++j)
+		a[row * m + j] -= factor * a[col * m + j];
+	    z[row] -= factor * z[col];
+	}
+    }
+    for (int row = m - 1; row >= 0; --row) {
+	for (int j = row + 1; j < m; ++j)
+	    z[row] -= a[row * m + j] * z[j];
+	z[row] /= a[row * m + row];
+    }
+
+    std::vector<double> weights(2 * width + 1);
+    for (int64_t k = -width; k <= width; ++k) {
+	double t = double(k) / double(width);
+	double power = 1;
+	double weight = 0;
+	for (int j = 0; j < m; ++j) {
+	    weight += z[j] * power;
+	    power *= t;
+	}
+	weights[k + width] = weight;
+    }
+    return weights;
+}
+
+static void savitzky_golay(const double* y, size_t n, int64_t width, int order, double* filtered)
+{
+    std::vector<double> weights = get_savitzky_golay_weights(width, order);
+    for (int64_t i = 0; i < int64_t(n); ++i) {
+	double sum = 0;
+	if (i >= width && i + width < int64_t(n)) {
+	    const double* window = y + i - width;
+	    for (size_t k = 0; k < weights.size(); ++k)
+		sum += weights[k] * window[k];
+	}
+	else {
+	    for (int64_t k = -width; k <= width; ++k)
+		sum += weights[k + width] * get_clamped(y, n, i + k);
+	}
+	filtered[i] = sum;
+    }
+}
+
+// y[i] = b0 x[i] + b1 x[i-1] + b2 x[i-2] - a1 y[i-1] - a2 y[i-2]
+struct Biquad
+{
+    double b0, b1, b2, a1, a2;
+};
+
+// second order sections of the Butterworth low pass, by the bilinear transform with a prewarped cutoff.
+static std::vector<Biquad> get_butterworth_sections(double cutoff, int order)
+{
+    std::vector<Biquad> sections;
+    double k = std::tan(UTILS_PI * cutoff);
+    for (int i = 0; i < order / 2; ++i) {
+	double q = 1 / (2 * std::sin((2 * i + 1) * UTILS_PI / (2 * order)));
+	double norm = 1 / (1 + k / q + k * k);
+	double b0 = k * k * norm;
+	sections.push_back({b0, 2 * b0, b0, 2 * (k * k - 1) * norm, (1 - k / q + k * k) * norm});
+    }
+    if (order % 2 == 1) {
+	double b0 = k / (k + 1);
+	sections.push_back({b0, b0, 0, (k - 1) / (k + 1), 0});
+    }
+    return sections;
+}
+
+// filters the values in place, starting in the steady state of the first value.
+static void apply_biquad(const Biquad& s, double* values, size_t n, bool backward)
+{
+    size_t first = backward ? n - 1 : 0;
+    double x1 = values[first], x2 = values[first], y1 = values[first], y2 = values[first];
+    for (size_t j = 0; j < n; ++j) {
+	double& value = values[backward ? n - 1 - j : j];
+	double x = value;
+	double y = s.b0 * x + s.b1 * x1 + s.b2 * x2 - s.a1 * y1 - s.a2 * y2;
+	x2 = x1;
+	x1 = x;
+	y2 = y1;
+	y1 = y;
+	value = y;
+    }
+}
+
+// forward and backward, so the phase is not shifted.
+static void butterworth(const double* y, size_t n, double cutoff, int order, double* filtered)
+{
+    std::copy(y, y + n, filtered);
+    std::vector<Biquad> sections = get_butterworth_sections(cutoff, order);
+    for (const auto& section : sections)
+	apply_biquad(section, filtered, n, false);
+    for (const auto& section : sections)
+	apply_biquad(section, filtered, n, true);
+}
+
+void apply_filter(const Filter& filter, const double* y, size_t n, double* filtered)
+{
+    if (n == 0)
+	return;
+
+    switch (filter.type) {
+    case FILTER_mean:
+	moving_average(y, n, int64_t(filter.width), filtered);
+	break;
+    case FILTER_median:
+	moving_median(y, n, int64_t(filter.width), filtered);
+	break;
+    case FILTER_gauss:
+	gaussian(y, n, filter.width, filtered);
+	break;
+    case FILTER_exp:
+	exponential(y, n, filter.width, filtered);
+	break;
+    case FILTER_savgol:
+	savitzky_golay(y, n, int64_t(filter.width), filter.order, filtered);
+	break;
+    case FILTER_butter:
+	butterworth(y, n, filter.width, filter.order, filtered);
+	break;
+    default:
+	std::copy(y, y + n, filtered);
+	break;
+    }
+}
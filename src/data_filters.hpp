@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+// The filters of the smooth command. Samples outside of the data are the first or the last value.
+enum Filter_Type
+{
+    FILTER_mean,   // moving average over 2 * width + 1 samples
+    FILTER_median, // moving median over 2 * width + 1 samples
+    FILTER_gauss,  // gaussian with the standard deviation width, approximated by three moving averages
+    FILTER_exp,    // exponential moving average with the time constant width
+    FILTER_savgol, // Savitzky-Golay, a polynomial of the order over 2 * width + 1 samples
+    FILTER_butter, // Butterworth low pass of the order with the cutoff frequency width (in 1 / samples), forward and backward
+    FILTER_CNT
+};
+
+inline const char* filter_name_table[FILTER_CNT] = {
+    "mean",
+    "median",
+    "gauss",
+    "exp",
+    "savgol",
+    "butter",
+};
+
+struct Filter
+{
+    Filter_Type type = FILTER_mean;
+    double width = 0;
+    int order = 0;
+};
+
+// FILTER_CNT if there is no filter with this name.
+Filter_Type get_filter_type(std::string_view name);
+
+// the default order of the filter, if none is given.
+int get_default_filter_order(Filter_Type type);
+
+// nullptr if the filter is valid for data of this size (the smallest of all filtered data), otherwise the reason.
+const char* check_filter(const Filter& filter, size_t size);
+
+// Filters the n values of y into filtered, which must not overlap with y. Runs in O(n) independent of the width,
+// except the median in O(n log(min(n, width))) and the Savitzky-Golay filter in O(n * width), its window must fit into the data.
+void apply_filter(const Filter& filter, const double* y, size_t n, double* filtered);
@@ -1,8 +1,14 @@
 #include "data_manager.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <fstream>
 #include <filesystem>
@@ -14,6 +20,9 @@
 #include "raylib.h"
 #include "utils.hpp"
 #include "command_parser.hpp"
+#include "plot_file.hpp"
+#include "plot_image.hpp"
+#include "object_operations.hpp"
 
 // coordinate system
 constexpr int COORDINATE_SYSTEM_GRID_SPACING = 60;
@@ -51,14 +60,16 @@ void Plot_Data::update_content_tree_element(size_t index)
 	content_element.content.push_back({x->content_element.name, false, x->info.color});
     }
     content_element.content.push_back({"size = " + std::to_string(y.size())});
+    if (y.get_capacity() > 0)
+	content_element.content.push_back({"capacity = " + std::to_string(y.get_capacity())});
 }
 
 static void draw_vp_camera_coordinate_system(VP_Camera camera, int target_spacing)
 {
-    int grid_resolution = std::max(GetScreenWidth(), GetScreenHeight()) / target_spacing;
+    int grid_resolution = std::max(get_plot_width(), get_plot_height()) / target_spacing;
     
-    Vec2<double> axis_length = {double(std::max(GetScreenWidth(), GetScreenHeight())) / camera.coord_sys.basis_x.length(),
-				double(std::max(GetScreenWidth(), GetScreenHeight())) / camera.coord_sys.basis_y.length()};
+    Vec2<double> axis_length = {double(std::max(get_plot_width(), get_plot_height())) / camera.coord_sys.basis_x.length(),
+				double(std::max(get_plot_width(), get_plot_height())) / camera.coord_sys.basis_y.length()};
     Vec2<double> t_origin = camera.coord_sys.origin;
     Vec2<double> t_grid_base_x = camera.coord_sys.basis_x * (axis_length.x / double(grid_resolution));
     Vec2<double> t_grid_base_y = camera.coord_sys.basis_y * (axis_length.y / double(grid_resolution));
@@ -66,48 +77,166 @@ static void draw_vp_camera_coordinate_system(VP_Camera camera, int target_spacin
     char text_buffer[64];
     for(int i = -grid_resolution; i < grid_resolution; ++i) {
 	Color color = i == 0 ? COORDINATE_SYSTEM_MAIN_AXIS_COLOR : COORDINATE_SYSTEM_GRID_COLOR;
-	DrawLineEx(t_origin + t_grid_base_y * grid_resolution + t_grid_base_x * i,
-		   t_origin + t_grid_base_y * grid_resolution * -1 + t_grid_base_x * i, 1, color);
-	DrawLineEx(t_origin + t_grid_base_x * grid_resolution + t_grid_base_y * i,
-		   t_origin + t_grid_base_x * grid_resolution * -1 + t_grid_base_y * i, 1, color);
+	plot_draw_line(t_origin + t_grid_base_y * grid_resolution + t_grid_base_x * i,
+		       t_origin + t_grid_base_y * grid_resolution * -1 + t_grid_base_x * i, 1, color);
+	plot_draw_line(t_origin + t_grid_base_x * grid_resolution + t_grid_base_y * i,
+		       t_origin + t_grid_base_x * grid_resolution * -1 + t_grid_base_y * i, 1, color);
 	
 	snprintf(text_buffer, 64, "%.5g", (t_grid_base_x.length() * double(i)) / camera.coord_sys.basis_x.length() - camera.origin_offset.x);
 	Vec2<double> text_pos = t_origin + t_grid_base_x * double(i);
-	DrawTextEx(*COORDINATE_SYSTEM_FONT, text_buffer, Vector2{float(text_pos.x), float(text_pos.y)}, COORDINATE_SYSTEM_FONT_SIZE, 0, COORDINATE_SYSTEM_FONT_COLOR);
+	plot_draw_text(*COORDINATE_SYSTEM_FONT, text_buffer, Vector2{float(text_pos.x), float(text_pos.y)}, COORDINATE_SYSTEM_FONT_SIZE, COORDINATE_SYSTEM_FONT_COLOR);
 	snprintf(text_buffer, 64, "%.5g", (t_grid_base_y.length() * double(i)) / camera.coord_sys.basis_y.length() - camera.origin_offset.y);
 	text_pos = t_origin + t_grid_base_y * (double(i) + double(i == 0 ? 0.25 : 0));
-	DrawTextEx(*COORDINATE_SYSTEM_FONT, text_buffer, Vector2{float(text_pos.x), float(text_pos.y)}, COORDINATE_SYSTEM_FONT_SIZE, 0, COORDINATE_SYSTEM_FONT_COLOR);
+	plot_draw_text(*COORDINATE_SYSTEM_FONT, text_buffer, Vector2{float(text_pos.x), float(text_pos.y)}, COORDINATE_SYSTEM_FONT_SIZE, COORDINATE_SYSTEM_FONT_COLOR);
     }
 }
 
+// the range of data space X values which is visible on screen.
+static void get_visible_x_range(const VP_Camera& camera, double& min_x, double& max_x)
+{
+    double x_a = app_coordinate_system.transform_to(Vec2<double>{0, 0} - camera.coord_sys.origin, camera.coord_sys).x - camera.origin_offset.x;
+    double x_b = app_coordinate_system.transform_to(Vec2<double>{double(get_plot_width()), 0} - camera.coord_sys.origin, camera.coord_sys).x - camera.origin_offset.x;
+    min_x = std::min(x_a, x_b);
+    max_x = std::max(x_a, x_b);
+}
+
 void Data_Manager::draw_plot_data()
 {
+    double visible_min_x, visible_max_x;
+    get_visible_x_range(camera, visible_min_x, visible_max_x);
+    double samples_per_pixel = 1.0 / camera.coord_sys.basis_x.length();
+    std::vector<X_Index_Range> visible_ranges;
+    
     for(const auto& pd : plot_data)
     {
-	if (!pd->info.visible)
+	if (!pd->info.visible || pd->size() == 0)
 	    continue;
+
+	visible_ranges.clear();
 	
-	for(size_t ix = 0; ix < pd->size(); ++ix)
-	{
-	    Vec2<double> screen_space_point = camera.coord_sys.transform_to(Vec2<double>{pd->x ? pd->x->y[ix] : double(ix), pd->y[ix]} + camera.origin_offset, app_coordinate_system);
-	    Vec2<double> prev_screen_space_point;
-	    if(pd->info.plot_type & PT_DISCRETE) {
-		DrawCircle(std::round(screen_space_point.x), std::round(screen_space_point.y), pd->info.thickness / 2.f, pd->info.color);
+	if (!pd->x) {
+	    // the index is the X value, so the visible range is known directly (one extra sample on each side for the lines).
+	    size_t begin = size_t(std::clamp(std::floor(visible_min_x) - 1, 0.0, double(pd->size())));
+	    size_t end = size_t(std::clamp(std::ceil(visible_max_x) + 2, 0.0, double(pd->size())));
+
+	    if (samples_per_pixel >= LOD_MIN_SAMPLES_PER_PIXEL) {
+		pd->lod.update(pd->y, pd->data_version);
+		int lod_level = pd->lod.select_level(samples_per_pixel);
+		if (lod_level >= 0) {
+		    draw_plot_data_decimated(pd, lod_level, begin, end);
+		    continue;
+		}
+	    }
+	    visible_ranges.push_back({begin, end});
+	}
+	else {
+	    pd->x->x_index.update(pd->x->y, pd->x->data_version);
+	    pd->x->x_index.get_visible_ranges(pd->x->y, pd->size(), visible_min_x, visible_max_x, visible_ranges);
+	}
+
+	// the GPU renderer is not available when drawing on the CPU
+	if (!is_drawing_image() && pd->renderer.draw(pd, camera, visible_ranges)) {
+	    // the renderer only draws the geometry
+	    if (pd->info.plot_type & PT_SHOW_INDEX) {
+		for (const X_Index_Range& range : visible_ranges)
+		    draw_plot_data_range(pd, range.begin, range.end, PT_SHOW_INDEX);
+	    }
+	    continue;
+	}
+	
+	for (const X_Index_Range& range : visible_ranges)
+	    draw_plot_data_range(pd, range.begin, range.end);
+    }
+}
+
+void Data_Manager::draw_plot_data_range(Plot_Data* pd, size_t begin, size_t end, int plot_type_mask)
+{
+    const int plot_type = pd->info.plot_type & plot_type_mask;
+    Vec2<double> prev_screen_space_point = {0, 0};
+    for(size_t ix = begin; ix < end; ++ix)
+    {
+	Vec2<double> screen_space_point = camera.coord_sys.transform_to(Vec2<double>{pd->x ? pd->x->y[ix] : double(ix), pd->y[ix]} + camera.origin_offset, app_coordinate_system);
+	if(plot_type & PT_DISCRETE) {
+	    plot_draw_circle(screen_space_point, pd->info.thickness / 2.f, pd->info.color);
+	}
+	if(plot_type & PT_INTERP_LINEAR) {
+	    if(ix > begin) {
+		plot_draw_line(prev_screen_space_point, screen_space_point, pd->info.thickness / 3.f, pd->info.color);
 	    }
-	    if(pd->info.plot_type & PT_INTERP_LINEAR) {
-		if(ix > 0) {
-		    DrawLineEx(prev_screen_space_point, screen_space_point, pd->info.thickness / 3.f, pd->info.color);
+	}
+	if(plot_type & PT_SHOW_INDEX) {
+	    plot_draw_text(*PLOT_DATA_FONT, std::to_string(ix).c_str(), Vector2{float(screen_space_point.x + 2.0), float(screen_space_point.y + 2.0)},
+			   PLOT_DATA_FONT_SIZE, pd->info.color);
+	}
+	prev_screen_space_point = screen_space_point;
+    }
+}
+
+// Draws the data from its LOD pyramid. Every bucket spans at most one pixel column and contributes its first, minimum,
+// maximum and last sample, so the drawn envelope matches the full resolution plot. Indices are not drawn at this density.
+void Data_Manager::draw_plot_data_decimated(Plot_Data* pd, int lod_level, size_t begin, size_t end)
+{
+    // the buckets count from the first index of the column (see Plot_LOD)
+    const size_t base = pd->lod.get_base();
+    const size_t bucket_size = pd->lod.get_bucket_size(lod_level);
+    const size_t bucket_end = std::min((base + end + bucket_size - 1) / bucket_size, pd->lod.get_bucket_end(lod_level));
+
+    auto get_screen_space_point = [&](size_t ix) {
+	return camera.coord_sys.transform_to(Vec2<double>{double(ix), pd->y[ix]} + camera.origin_offset, app_coordinate_system);
+    };
+
+    Vec2<double> prev_screen_space_point = {0, 0};
+    bool has_prev_point = false;
+    
+    for (size_t b = (base + begin) / bucket_size; b < bucket_end; ++b)
+    {
+	const LOD_Bucket& bucket = pd->lod.get_bucket(lod_level, b);
+	size_t bucket_points[4] = {
+	    std::max(b * bucket_size, base) - base,
+	    std::min(bucket.min_idx, bucket.max_idx) - base,
+	    std::max(bucket.min_idx, bucket.max_idx) - base,
+	    std::min((b + 1) * bucket_size, base + pd->y.size()) - 1 - base,
+	};
+
+	if(pd->info.plot_type & PT_INTERP_LINEAR) {
+	    for (int i = 0; i < 4; ++i) {
+		if (i > 0 && bucket_points[i] == bucket_points[i - 1])
+		    continue;
+		Vec2<double> screen_space_point = get_screen_space_point(bucket_points[i]);
+		if (has_prev_point) {
+		    plot_draw_line(prev_screen_space_point, screen_space_point, pd->info.thickness / 3.f, pd->info.color);
 		}
+		prev_screen_space_point = screen_space_point;
+		has_prev_point = true;
 	    }
-	    if(pd->info.plot_type & PT_SHOW_INDEX) {
-		DrawTextEx(*PLOT_DATA_FONT, std::to_string(ix).c_str(), Vector2{float(screen_space_point.x + 2.0), float(screen_space_point.y + 2.0)},
-			   PLOT_DATA_FONT_SIZE, 0, pd->info.color);
+	}
+	if(pd->info.plot_type & PT_DISCRETE) {
+	    for (size_t ix : {bucket.min_idx - base, bucket.max_idx - base}) {
+		Vec2<double> screen_space_point = get_screen_space_point(ix);
+		plot_draw_circle(screen_space_point, pd->info.thickness / 2.f, pd->info.color);
 	    }
-	    prev_screen_space_point = screen_space_point;
 	}
     }
 }
 
+double Data_Manager::screen_x_to_camera_x(double screen_x) const
+{
+    return app_coordinate_system.transform_to(Vec2<double>{screen_x, 0} - camera.coord_sys.origin, camera.coord_sys).x - camera.origin_offset.x;
+}
+
+// y of func at every pixel column of the screen.
+std::vector<double> Data_Manager::evaluate_at_pixel_columns(const Function& func) const
+{
+    std::vector<double> values(std::max(get_plot_width(), 0));
+    for (size_t ix = 0; ix < values.size(); ++ix) {
+	values[ix] = screen_x_to_camera_x(double(ix));
+    }
+    func.evaluate_many(values.data(), values.data(), values.size());
+    return values;
+}
+
+// Functions are sampled in two batches: once at every pixel column, then every column is subdivided into as many samples
+// as its screen space gap in y is pixels long (at most 1 / dx_lower_limit).
 void Data_Manager::draw_functions()
 {
     uint64_t draw_cnt = 0;
@@ -115,70 +244,62 @@ void Data_Manager::draw_functions()
     const uint64_t min_draw_cnt = 180'000; // dx_lower_limit_base has priority
     const double dx_lower_limit_base = 0.001;
     static double dx_lower_limit = dx_lower_limit_base;
+
+    const double screen_height = get_plot_height();
+    std::vector<double> screen_x;
+    std::vector<double> values;
+    
+    auto to_screen_space = [&](double x, double func_y) {
+	return camera.coord_sys.transform_to(Vec2<double>{screen_x_to_camera_x(x), func_y} + camera.origin_offset, app_coordinate_system);
+    };
+    
+    auto draw_point = [&](double x, double func_y, Color color) {
+	Vec2<double> screen_space_point = to_screen_space(x, func_y);
+	if (screen_space_point.y >= 0 && screen_space_point.y <= screen_height) {
+	    plot_draw_pixel(screen_space_point, color);
+	    ++draw_cnt;
+	}
+    };
     
     for(const auto& func : functions)
     {
 	if (!func->info.visible)
 	    continue;
 
-        double d_sqr = 0;
-        double prev_y = 0;
-        const int max_refine_itr = 5;
-        const double dx_default = 1.0;
-        double dx = dx_default;
-        int screen_height = GetScreenHeight();
-        bool clipped = false;
-        
-	for(double x = 0; x < GetScreenWidth(); x += dx)
-	{
-            double camera_space_x;
-            Vec2<double> screen_space_point;
-            
-            for(int i = 0; i < max_refine_itr; ++i)
-            {
-                camera_space_x = app_coordinate_system.transform_to(Vec2<double>{x, 0} - camera.coord_sys.origin, camera.coord_sys).x - camera.origin_offset.x;
-                screen_space_point = camera.coord_sys.transform_to(Vec2<double>{camera_space_x, func->operator()(camera_space_x)} + camera.origin_offset,
-                                                                   app_coordinate_system);
-                if (screen_space_point.y < 0 || screen_space_point.y > screen_height) {
-                    clipped = true;
-                    dx = dx_default;
-                    break;
-                }
-                
-                if (x == 0) {
-                    prev_y = screen_space_point.y;
-                }
-                
-                d_sqr = sqr(dx) + sqr(screen_space_point.y - prev_y);
-
-                if (d_sqr > sqr(1.2) && dx > dx_lower_limit) {
-                    x -= dx;
-                    dx *= 0.75;
-                }
-                else if (d_sqr < sqr(0.8)) {
-                    x -= dx;
-                    dx *= 1.25;
-                }
-                else {
-                    break;
-                }
-                x += dx;
-            }
-
-            if (!clipped) {
-                DrawPixelV(screen_space_point, func->info.color);
-                ++draw_cnt;
-            }
-            prev_y = screen_space_point.y;
-            clipped = false;
-
-            if (draw_cnt > max_draw_cnt) {
-                goto stop_drawing;
-            }
-	}
-    }
-
-stop_drawing:
+	std::vector<double> column_values = evaluate_at_pixel_columns(*func);
+	std::vector<double> column_screen_y(column_values.size());
+	for (size_t ix = 0; ix < column_values.size(); ++ix) {
+	    column_screen_y[ix] = std::clamp(to_screen_space(double(ix), column_values[ix]).y, 0.0, screen_height);
+	}
+
+	screen_x.clear();
+	const size_t max_subdivisions = size_t(1.0 / dx_lower_limit);
+	for (size_t ix = 0; ix + 1 < column_values.size() && draw_cnt + screen_x.size() <= max_draw_cnt; ++ix) {
+	    double gap = std::abs(column_screen_y[ix + 1] - column_screen_y[ix]);
+	    size_t subdivisions = std::min(size_t(std::ceil(gap)), max_subdivisions);
+	    for (size_t k = 1; k < subdivisions; ++k) {
+		screen_x.push_back(double(ix) + double(k) / double(subdivisions));
+	    }
+	}
+
+	values.resize(screen_x.size());
+	for (size_t i = 0; i < screen_x.size(); ++i) {
+	    values[i] = screen_x_to_camera_x(screen_x[i]);
+	}
+	func->evaluate_many(values.data(), values.data(), values.size());
+
+	Color color = func->info.color;
+	for (size_t ix = 0; ix < column_values.size(); ++ix) {
+	    draw_point(double(ix), column_values[ix], color);
+	}
+	for (size_t i = 0; i < screen_x.size(); ++i) {
+	    draw_point(screen_x[i], values[i], color);
+	}
+
+	if (draw_cnt > max_draw_cnt) {
+	    break;
+	}
+    }
     
     if (draw_cnt > max_draw_cnt) {
         dx_lower_limit *= 1.25;
@@ -193,18 +314,31 @@ Data_Manager::Data_Manager() : key_board_lock_id(get_uuid())
     camera.coord_sys.origin = {double(plot_padding.x), double(SCREEN_HEIGHT - plot_padding.y)};
     camera.coord_sys.basis_x = {1, 0};
     camera.coord_sys.basis_y = {0, -1};
+    undo_checkpoints.emplace_back(); // nothing, before any command
 }
 
 Data_Manager::~Data_Manager()
 {
+    fit_worker.cancel();
+    unload_gpu_resources();
     for (auto pd : plot_data)
 	delete pd;
     for (auto f : functions)
 	delete f;
-    for (auto pd : original_plot_data)
-	delete pd;
-    for (auto f : original_functions)
-	delete f;
+    for (size_t i = undo_checkpoints.size(); i > 0; --i)
+	delete_undo_checkpoint(i - 1);
+}
+
+// GPU resources must be released while the window (and its OpenGL context) still exists.
+void Data_Manager::unload_gpu_resources()
+{
+    for (auto pd : plot_data)
+	pd->renderer.unload();
+    for (auto& checkpoint : undo_checkpoints) {
+	for (auto pd : checkpoint.plot_data)
+	    pd->renderer.unload();
+    }
+    unload_plot_renderer_resources();
 }
 
 Plot_Data* Data_Manager::new_plot_data(Plot_Data *data)
@@ -225,6 +359,8 @@ Plot_Data* Data_Manager::new_plot_data(Plot_Data *data)
 
 void Data_Manager::delete_plot_data(Plot_Data *data)
 {
+    std::replace(loading_data.begin(), loading_data.end(), data, (Plot_Data*)nullptr);
+    
     // resolve reference
     for (size_t i = 0; i < data->x_referencees.size(); ++i) {
 	data->x_referencees[i]->x = nullptr;
@@ -275,8 +411,9 @@ Function* Data_Manager::change_function_type(Function *orig_func, Function* new_
     return new_func;
 }
 
-void Data_Manager::copy_data_to_data(std::vector<Plot_Data*>& from_plot_data, std::vector<Plot_Data*>& to_plot_data,
-				     std::vector<Function*>& from_functions, std::vector<Function*>& to_functions)
+// References between the copied objects (X, X referencees and fitted data) are redirected to the copies.
+void Data_Manager::copy_data_to_data(const std::vector<Plot_Data*>& from_plot_data, std::vector<Plot_Data*>& to_plot_data,
+				     const std::vector<Function*>& from_functions, std::vector<Function*>& to_functions)
 {
     for(size_t i = 0; i < to_plot_data.size(); ++i) {
 	delete to_plot_data[i];
@@ -291,37 +428,384 @@ void Data_Manager::copy_data_to_data(std::vector<Plot_Data*>& from_plot_data, st
     to_plot_data.resize(from_plot_data.size(), nullptr);
     to_functions.resize(from_functions.size(), nullptr);
 
+    std::unordered_map<const Plot_Data*, Plot_Data*> copies;
     for(size_t i = 0; i < from_plot_data.size(); ++i) {
         to_plot_data[i] = new Plot_Data;
 	*to_plot_data[i] = *from_plot_data[i];
+	copies[from_plot_data[i]] = to_plot_data[i];
+    }
+
+    auto get_copy = [&](const Plot_Data* pd) -> Plot_Data* {
+	auto it = copies.find(pd);
+	return it != copies.end() ? it->second : nullptr;
+    };
+
+    for (Plot_Data* pd : to_plot_data) {
+	pd->x = get_copy(pd->x);
+	for (auto& referencee : pd->x_referencees)
+	    referencee = get_copy(referencee);
+	std::erase(pd->x_referencees, nullptr);
     }
 
     for(size_t i = 0; i < from_functions.size(); ++i) {
-        to_functions[i] = new Generic_Function;
-	*to_functions[i] = *from_functions[i];
+	to_functions[i] = from_functions[i]->clone();
+	to_functions[i]->fit_from_data = get_copy(from_functions[i]->fit_from_data);
     }
 }
 
+void Data_Manager::add_undo_checkpoint()
+{
+    Undo_Checkpoint checkpoint;
+    checkpoint.command_idx = g_all_commands.get_index();
+    checkpoint.graph_color_array_idx = graph_color_array_idx;
+    checkpoint.replay_seconds = seconds_since_checkpoint;
+    copy_data_to_data(plot_data, checkpoint.plot_data, functions, checkpoint.functions);
+    for (Plot_Data* pd : checkpoint.plot_data) {
+	// the values are shared with the current data, the cached representations are rebuilt after restoring instead.
+	pd->lod.clear();
+	pd->x_index.clear();
+    }
+
+    auto it = std::upper_bound(undo_checkpoints.begin(), undo_checkpoints.end(), checkpoint.command_idx,
+			       [](int64_t command_idx, const Undo_Checkpoint& c) { return command_idx < c.command_idx; });
+    size_t idx = it - undo_checkpoints.begin();
+    undo_checkpoints.insert(it, std::move(checkpoint));
+    if (idx + 1 < undo_checkpoints.size())
+	undo_checkpoints[idx + 1].replay_seconds = std::max(0.0, undo_checkpoints[idx + 1].replay_seconds - seconds_since_checkpoint);
+    seconds_since_checkpoint = 0;
+
+    // stay within the memory budget, the state after loading is always kept.
+    while (get_undo_checkpoint_memory() > UNDO_CHECKPOINT_MEMORY && undo_checkpoints.size() > 1) {
+	size_t drop_idx = 1;
+	double drop_cost = std::numeric_limits<double>::infinity();
+	for (size_t i = 1; i < undo_checkpoints.size(); ++i) {
+	    // replaying across the dropped checkpoint merges its gap with the next one.
+	    double cost = undo_checkpoints[i].replay_seconds + (i + 1 < undo_checkpoints.size() ? undo_checkpoints[i + 1].replay_seconds : 0);
+	    if (cost < drop_cost) {
+		drop_cost = cost;
+		drop_idx = i;
+	    }
+	}
+	delete_undo_checkpoint(drop_idx);
+    }
+}
+
+// the bytes of the values which are only kept alive by the checkpoints, buffers shared between them are counted once.
+size_t Data_Manager::get_undo_checkpoint_memory() const
+{
+    std::unordered_set<const void*> current_buffers;
+    for (const Plot_Data* pd : plot_data)
+	current_buffers.insert(pd->y.get_owned_buffer());
+
+    std::unordered_set<const void*> counted_buffers;
+    size_t memory_size = 0;
+    for (const auto& checkpoint : undo_checkpoints) {
+	for (const Plot_Data* pd : checkpoint.plot_data) {
+	    const void* buffer = pd->y.get_owned_buffer();
+	    if (buffer && !current_buffers.contains(buffer) && counted_buffers.insert(buffer).second)
+		memory_size += pd->y.size() * sizeof(double);
+	}
+    }
+    return memory_size;
+}
+
+void Data_Manager::delete_undo_checkpoint(size_t idx)
+{
+    Undo_Checkpoint& checkpoint = undo_checkpoints[idx];
+    if (idx + 1 < undo_checkpoints.size())
+	undo_checkpoints[idx + 1].replay_seconds += checkpoint.replay_seconds;
+    for (auto pd : checkpoint.plot_data)
+	delete pd;
+    for (auto f : checkpoint.functions)
+	delete f;
+    undo_checkpoints.erase(undo_checkpoints.begin() + idx);
+}
+
+// restores the closest checkpoint before command_idx and replays the commands after it.
+void Data_Manager::restore_undo_checkpoint(int64_t command_idx)
+{
+    auto time_begin = std::chrono::steady_clock::now();
+
+    auto it = std::upper_bound(undo_checkpoints.begin(), undo_checkpoints.end(), command_idx,
+			       [](int64_t command_idx, const Undo_Checkpoint& c) { return command_idx < c.command_idx; });
+    if (it == undo_checkpoints.begin()) {
+	logger.log_error("There is no state to revert to.");
+	return;
+    }
+    --it;
+
+    for (auto pd : plot_data)
+	pd->renderer.unload();
+    graph_color_array_idx = it->graph_color_array_idx;
+    copy_data_to_data(it->plot_data, plot_data, it->functions, functions);
+    update_element_indices();
+    g_frame_dirty = true;
+
+    re_run_commands(it->command_idx + 1);
+
+    seconds_since_checkpoint = 0;
+    command_executed(std::chrono::duration<double>(std::chrono::steady_clock::now() - time_begin).count());
+}
+
+void Data_Manager::revert_command()
+{
+    if (is_fitting()) {
+	cancel_fit(); // reverts the command which started the fit
+	return;
+    }
+    if (g_all_commands.decr_command_idx()) {
+	logger.log_info("Revert command.\n");
+	restore_undo_checkpoint(g_all_commands.get_index());
+    }
+}
+
+// the current state is the one before the command, so only the command itself is executed again.
+void Data_Manager::revert_reverting()
+{
+    finish_fit();
+    if (g_all_commands.incr_command_idx()) {
+	logger.log_info("Revert reverting.\n");
+	auto time_begin = std::chrono::steady_clock::now();
+	re_run_commands(g_all_commands.get_index());
+	command_executed(std::chrono::duration<double>(std::chrono::steady_clock::now() - time_begin).count());
+    }
+}
+
+// commands after the current one are dropped from the command list, once a new command is added.
+void Data_Manager::discard_redo_checkpoints()
+{
+    while (undo_checkpoints.size() > 1 && undo_checkpoints.back().command_idx > g_all_commands.get_index())
+	delete_undo_checkpoint(undo_checkpoints.size() - 1);
+}
+
+void Data_Manager::command_executed(double seconds)
+{
+    int64_t command_idx = g_all_commands.get_index();
+    for (const auto& checkpoint : undo_checkpoints) {
+	if (checkpoint.command_idx == command_idx) {
+	    seconds_since_checkpoint = 0;
+	    return;
+	}
+    }
+    
+    seconds_since_checkpoint += seconds;
+    if (seconds_since_checkpoint >= UNDO_CHECKPOINT_SECONDS)
+	add_undo_checkpoint();
+}
+
+void Data_Manager::fit_command_executed(double seconds)
+{
+    fit_command_seconds = seconds;
+}
+
+// The fit runs on a copy of the function and the data, so both can be used while it is running.
+void Data_Manager::start_fit(Function* function, Plot_Data* data, const std::vector<double*>& param_list, int iterations)
+{
+    finish_fit();
+    if (data->size() == 0 || param_list.empty()) {
+	logger.log_error("Can't fit, because there is no data or no parameter.");
+	return;
+    }
+
+    std::vector<int> param_indices;
+    for (double* param : param_list)
+	param_indices.push_back(function->get_parameter_ref_idx(param));
+    fit_worker.start(*function, get_fit_samples(data), param_indices, iterations);
+    fitting_function = function;
+    fit_begin_time = std::chrono::steady_clock::now();
+    copy_fit_progress();
+}
+
+// waits for the running fit and applies its result.
+void Data_Manager::finish_fit()
+{
+    if (!fitting_function)
+	return;
+
+    fit_worker.wait();
+    copy_fit_progress();
+    const Fit_Result& result = fitting_function->fit_result;
+    if (result.valid && !result.converged && result.max_iterations > 0)
+	logger.log_info("The fit did not converge in %d iterations.\n", result.max_iterations);
+    fitting_function = nullptr;
+
+    if (fit_command_seconds >= 0) {
+	command_executed(fit_command_seconds + std::chrono::duration<double>(std::chrono::steady_clock::now() - fit_begin_time).count());
+	fit_command_seconds = -1;
+    }
+}
+
+void Data_Manager::cancel_fit()
+{
+    if (!fitting_function)
+	return;
+
+    fit_worker.cancel();
+    fit_command_seconds = -1;
+    logger.log_info("Canceled the fit.\n");
+    
+    // while a file is loading, the parameters of the last iteration are kept, the loaded file is the new starting point.
+    if (is_loading()) {
+	copy_fit_progress();
+	fitting_function = nullptr;
+	return;
+    }
+    fitting_function = nullptr;
+    revert_command();
+}
+
+void Data_Manager::copy_fit_progress()
+{
+    std::vector<double> param_values;
+    Fit_Result result;
+    fit_worker.get_progress(param_values, result);
+    for (size_t i = 0; i < param_values.size(); ++i)
+	*fitting_function->get_parameter_ref(result.param_indices[i]) = param_values[i];
+    if (result.iterations != fitting_function->fit_result.iterations || result.running != fitting_function->fit_result.running)
+	g_frame_dirty = true;
+    fitting_function->fit_result = result;
+}
+
+void Data_Manager::update_fitting()
+{
+    if (!fitting_function)
+	return;
+
+    if (fit_worker.is_finished())
+	finish_fit();
+    else
+	copy_fit_progress();
+}
+
 void Data_Manager::load_external_plot_data(const std::string& file_name)
 {
-    std::vector<Plot_Data*> data_list = parse_numeric_csv_file(file_name);
+    bool is_plot_file = get_file_extension(file_name) == PLOT_FILE_EXTENSION;
+    std::vector<Plot_Data*> data_list = is_plot_file ? read_plot_file(file_name) : parse_numeric_csv_file(file_name);
     if (data_list.empty()) {
 	return;
     }
     
     for(const auto data : data_list) {
+	Color color = data->info.color;
 	new_plot_data(data);
+	if (is_plot_file)
+	    data->info.color = color;
     }
+    update_references();
     fit_camera_to_plot();
+    finish_loading(file_name);
+}
+
+// Loads the file on a background thread. The data is shown while it is loading, files dropped meanwhile are queued.
+void Data_Manager::load_external_plot_data_async(const std::string& file_name)
+{
+    if (csv_loader.is_active()) {
+	loading_queue.push_back(file_name);
+	return;
+    }
+    
+    if (!csv_loader.start(file_name)) {
+	logger.log_error("Failed to open file '%s'.", file_name.c_str());
+	return;
+    }
+    loading_data.clear();
+    loading_camera = camera;
+}
+
+void Data_Manager::cancel_loading()
+{
+    loading_queue.clear();
+    csv_loader.cancel();
+    if (!script_queue.empty()) {
+	logger.log_info("Canceled %d queued scripts.\n", int(script_queue.size()));
+	script_queue.clear();
+    }
+}
+
+// The commands of a script need the data of the files dropped before it.
+void Data_Manager::run_script_after_loading(const std::string& file_name)
+{
+    if (is_loading()) {
+	script_queue.push_back(file_name);
+	return;
+    }
+    run_command_file_absolute_path(file_name);
+}
 
-    original_graph_color_array_idx = graph_color_array_idx;
-    copy_data_to_data(plot_data, original_plot_data, functions, original_functions);
+// moves the newly parsed rows into the plot data.
+void Data_Manager::update_loading()
+{
+    if (!csv_loader.is_active()) {
+	while (!loading_queue.empty() && !csv_loader.is_active()) {
+	    std::string file_name = loading_queue.front();
+	    loading_queue.erase(loading_queue.begin());
+	    if (get_file_extension(file_name) == PLOT_FILE_EXTENSION)
+		load_external_plot_data(file_name);
+	    else
+		load_external_plot_data_async(file_name);
+	}
+	
+	if (!csv_loader.is_active() && !script_queue.empty()) {
+	    std::vector<std::string> scripts = std::move(script_queue);
+	    script_queue.clear();
+	    for (const std::string& file_name : scripts)
+		run_command_file_absolute_path(file_name);
+	}
+	return;
+    }
+    
+    std::vector<Csv_Block> blocks;
+    csv_loader.take_blocks(blocks);
+
+    for (auto& block : blocks) {
+	for (size_t c = 0; c < block.columns.size(); ++c) {
+	    while (loading_data.size() <= c)
+		loading_data.push_back(new_plot_data());
+	    
+	    Plot_Data* pd = loading_data[c];
+	    if (!pd)
+		continue;
+	    pd->info.header += block.headers[c];
+	    append_values(pd, block.columns[c]);
+	}
+    }
 
+    if (!blocks.empty()) {
+	g_frame_dirty = true;
+	if (camera == loading_camera) {
+	    fit_camera_to_plot();
+	    loading_camera = camera;
+	}
+    }
+    
+    if (!csv_loader.is_active()) {
+	const std::string& file_name = csv_loader.get_file_name();
+	if (csv_loader.was_canceled()) {
+	    logger.log_info("Canceled loading file '%s' after %.1f MB.\n", file_name.c_str(), double(csv_loader.get_bytes_parsed()) / 1e6);
+	}
+	else {
+	    logger.log_info("Parsed '%s' (%.1f MB) in %.3f s, %.2f GB/s.\n", file_name.c_str(), double(csv_loader.get_bytes_parsed()) / 1e6,
+			    csv_loader.get_seconds(), double(csv_loader.get_bytes_parsed()) / 1e9 / std::max(csv_loader.get_seconds(), 1e-9));
+	}
+	loading_data.clear();
+	finish_loading(file_name);
+    }
+}
+
+// a loaded file is the new starting point for reverting commands.
+void Data_Manager::finish_loading(const std::string& file_name)
+{
+    finish_fit();
     logger.log_info("Loaded file '%s'.", file_name.c_str());
     if (g_all_commands.has_commands()) {
 	g_all_commands.clear();
 	logger.log_info(" and" UTILS_BRIGHT_RED " cleared the command list." UTILS_END_COLOR);
     }
+
+    for (size_t i = undo_checkpoints.size(); i > 0; --i)
+	delete_undo_checkpoint(i - 1);
+    seconds_since_checkpoint = 0;
+    add_undo_checkpoint();
     logger.log_info("\n");
 }
 
@@ -330,8 +814,135 @@ bool Data_Manager::keyboard_access()
     return g_keyboard_lock == 0 || g_keyboard_lock == key_board_lock_id;
 }
 
+size_t Data_Manager::add_data(Data_Column values, const std::string& header)
+{
+    Plot_Data* pd = new_plot_data();
+    pd->y = std::move(values);
+    pd->info.header = header;
+    g_frame_dirty = true;
+    return pd->index;
+}
+
+void Data_Manager::set_data(size_t data_idx, Data_Column values)
+{
+    if (data_idx >= plot_data.size()) {
+	logger.log_error("The data with index '%zu' does not exist.", data_idx);
+	return;
+    }
+    Plot_Data* pd = plot_data[data_idx];
+    size_t capacity = pd->y.get_capacity();
+    pd->y = std::move(values);
+    pd->y.set_capacity(capacity);
+    pd->modified();
+}
+
+// Small blocks keep the cached representations up to date value by value, like update_value_data, larger ones rebuild them.
+void Data_Manager::update_data_block(size_t data_idx, size_t value_idx, std::span<const double> values)
+{
+    constexpr size_t INCREMENTAL_BLOCK_SIZE = 64;
+    
+    if (data_idx >= plot_data.size()) {
+	logger.log_error("The data with index '%zu' does not exist.", data_idx);
+	return;
+    }
+    Plot_Data* pd = plot_data[data_idx];
+    if (value_idx > pd->y.size()) {
+	logger.log_error("The value index '%zu' is past the end of data %zu with %zu values.", value_idx, data_idx, pd->y.size());
+	return;
+    }
+
+    if (value_idx + values.size() > pd->y.size()) {
+	std::vector<double>& y = pd->y.edit();
+	y.resize(value_idx + values.size());
+	std::copy(values.begin(), values.end(), y.begin() + value_idx);
+	pd->y.apply_capacity();
+	pd->modified();
+	return;
+    }
+
+    // in place, a rolling window is not moved
+    std::span<double> y = pd->y.edit_window();
+    std::copy(values.begin(), values.end(), y.begin() + value_idx);
+    if (values.size() > INCREMENTAL_BLOCK_SIZE) {
+	pd->modified();
+	return;
+    }
+    for (size_t i = value_idx; i < value_idx + values.size(); ++i) {
+	pd->lod.update_value(pd->y, i);
+	pd->x_index.update_value(pd->y, i);
+	pd->renderer.update_value(pd, i);
+	for (Plot_Data* referencee : pd->x_referencees)
+	    referencee->renderer.update_value(referencee, i);
+    }
+    g_frame_dirty = true;
+}
+
+void Data_Manager::set_data_x(size_t data_idx, size_t x_data_idx)
+{
+    if (data_idx >= plot_data.size() || x_data_idx >= plot_data.size()) {
+	logger.log_error("The data with index '%zu' does not exist.", std::max(data_idx, x_data_idx));
+	return;
+    }
+    plot_data[data_idx]->x = plot_data[x_data_idx];
+    update_references();
+    g_frame_dirty = true;
+}
+
+FPlot::Data_Stream* Data_Manager::open_stream(size_t data_idx, size_t capacity)
+{
+    streams.push_back(std::make_unique<FPlot::Data_Stream>(data_idx, capacity));
+    return streams.back().get();
+}
+
+void Data_Manager::close_stream(FPlot::Data_Stream* stream)
+{
+    auto it = std::find_if(streams.begin(), streams.end(), [&](const auto& s) { return s.get() == stream; });
+    if (it == streams.end())
+	return;
+    drain_stream(**it);
+    streams.erase(it);
+}
+
+// The cached representations are extended, and moved along with the window of a data with a capacity,
+// the renderers follow on draw.
+void Data_Manager::append_values(Plot_Data* pd, std::span<const double> values)
+{
+    if (values.empty())
+	return;
+    pd->y.append(values);
+    pd->lod.append(pd->y);
+    pd->x_index.append(pd->y);
+    g_frame_dirty = true;
+}
+
+void Data_Manager::update_streams()
+{
+    for (auto& stream : streams)
+	drain_stream(*stream);
+}
+
+// the data is looked up by its index every time, so a stream survives reverting commands. Without the data the values are dropped.
+void Data_Manager::drain_stream(FPlot::Data_Stream& stream)
+{
+    stream_values.clear();
+    stream.pop(stream_values);
+    if (stream_values.empty())
+	return;
+    if (stream.get_data_idx() >= plot_data.size()) {
+	stream.drop(stream_values.size());
+	return;
+    }
+    append_data(stream.get_data_idx(), stream_values);
+}
+
 void Data_Manager::update_viewport()
 {
+    update_loading();
+    update_fitting();
+    update_streams();
+    
+    const VP_Camera old_camera = camera;
+    
     static int old_g_screen_height = GetScreenHeight();
     camera.coord_sys.origin.y += GetScreenHeight() - old_g_screen_height;
     old_g_screen_height = GetScreenHeight();
@@ -363,30 +974,46 @@ void Data_Manager::update_viewport()
     if (keyboard_access())
     {
 	if (IsKeyPressed(KEY_SPACE) && !g_keyboard_lock) {
-	    fit_camera_to_plot();
+	    if (IsKeyDown(KEY_LEFT_SHIFT))
+		fit_camera_y_to_visible_range();
+	    else
+		fit_camera_to_plot();
 	}
 	
 	if (IsKeyDown(KEY_LEFT_CONTROL)) {
-	    if (((IsKeyPressed(KEY_LEFT) || IsKeyPressed(KEY_COMMA)) && g_all_commands.decr_command_idx()) ||
-		((IsKeyPressed(KEY_RIGHT) || IsKeyPressed(KEY_PERIOD)) && g_all_commands.incr_command_idx()))
-	    {
-		if(IsKeyPressed(KEY_LEFT) || IsKeyPressed(KEY_COMMA))
-		    logger.log_info("Revert command.\n");
-		if(IsKeyPressed(KEY_RIGHT) || IsKeyPressed(KEY_PERIOD))
-		    logger.log_info("Revert reverting.\n");
-
-		graph_color_array_idx = original_graph_color_array_idx;
-		copy_data_to_data(original_plot_data, plot_data, original_functions, functions);
-		re_run_all_commands();
+	    bool revert_key_pressed = IsKeyPressed(KEY_LEFT) || IsKeyPressed(KEY_COMMA);
+	    bool revert_reverting_key_pressed = IsKeyPressed(KEY_RIGHT) || IsKeyPressed(KEY_PERIOD);
+	    if ((revert_key_pressed || revert_reverting_key_pressed) && is_loading()) {
+		logger.log_error("Commands can not be reverted, while a file is loading.");
+	    }
+	    else if (revert_key_pressed) {
+		revert_command();
+	    }
+	    else if (revert_reverting_key_pressed) {
+		revert_reverting();
 	    }
 	}
     }
-    
+
+    if (!(camera == old_camera))
+	g_frame_dirty = true;
 }
 
 void Data_Manager::update_content_tree(Content_Tree& content_tree)
 {
     content_tree.clear();
+
+    if (csv_loader.is_active()) {
+	loading_element.name = "loading '" + std::filesystem::path(csv_loader.get_file_name()).filename().string() + "' "
+	    + std::to_string(int(csv_loader.get_progress() * 100)) + "%";
+	loading_element.content.clear();
+	loading_element.content.push_back({"cancel with the command 'cancel'"});
+	if (!loading_queue.empty())
+	    loading_element.content.push_back({std::to_string(loading_queue.size()) + " more files queued"});
+	if (!script_queue.empty())
+	    loading_element.content.push_back({std::to_string(script_queue.size()) + " scripts queued"});
+	content_tree.add_element(&loading_element);
+    }
     
     for (size_t i = 0; i < plot_data.size(); ++i) {
 	plot_data[i]->update_content_tree_element(i);
@@ -411,9 +1038,33 @@ void Data_Manager::zero_coord_sys_origin()
     fit_camera_to_plot(true);
 }
 
+// Extends the bounds by the samples [begin, end) of the data, in O(log n) with the min max pyramids (see Plot_LOD),
+// which are only rebuilt if the data was modified. NaN are skipped.
+static void add_plot_data_bounds(Plot_Data* pd, size_t begin, size_t end, double& min_x, double& max_x, double& min_y, double& max_y)
+{
+    if (begin >= end)
+	return;
+
+    if (pd->x) {
+	pd->x->lod.update(pd->x->y, pd->x->data_version);
+	LOD_Bucket x_extrema = pd->x->lod.get_range_extrema(pd->x->y, begin, end);
+	max_x = pd->x->y[x_extrema.max_idx] > max_x ? pd->x->y[x_extrema.max_idx] : max_x;
+	min_x = pd->x->y[x_extrema.min_idx] < min_x ? pd->x->y[x_extrema.min_idx] : min_x;
+    }
+    else {
+	max_x = double(end - 1) > max_x ? double(end - 1) : max_x;
+	min_x = double(begin) < min_x ? double(begin) : min_x;
+    }
+
+    pd->lod.update(pd->y, pd->data_version);
+    LOD_Bucket y_extrema = pd->lod.get_range_extrema(pd->y, begin, end);
+    max_y = pd->y[y_extrema.max_idx] > max_y ? pd->y[y_extrema.max_idx] : max_y;
+    min_y = pd->y[y_extrema.min_idx] < min_y ? pd->y[y_extrema.min_idx] : min_y;
+}
+
 void Data_Manager::fit_camera_to_plot(bool go_to_zero)
 {
-    camera.coord_sys.origin = {double(plot_padding.x), double(GetScreenHeight() - plot_padding.y)};
+    camera.coord_sys.origin = {double(plot_padding.x), double(get_plot_height() - plot_padding.y)};
     
     double max_x = -HUGE_VAL, max_y = -HUGE_VAL, min_x = HUGE_VAL, min_y = HUGE_VAL;
 
@@ -425,40 +1076,21 @@ void Data_Manager::fit_camera_to_plot(bool go_to_zero)
 	if (!pd->info.visible)
 	    continue;
 
-	if (pd->x) {
-	    for(double val : pd->x->y) {
-		max_x = val > max_x ? val : max_x;
-		min_x = val < min_x ? val : min_x;
-	    }
-	}
-	else {
-	    for(size_t i = 0; i < pd->size(); ++i) {
-		max_x = i > max_x ? i : max_x;
-		min_x = i < min_x ? i : min_x;
-	    }	    
-	}
-	
-	for(double val : pd->y) {
-	    max_y = val > max_y ? val : max_y;
-	    min_y = val < min_y ? val : min_y;
-	}
+	add_plot_data_bounds(pd, 0, pd->size(), min_x, max_x, min_y, max_y);
     }
 
     for(const auto& func : functions) {
 	if (!func->info.visible)
 	    continue;
 
-	for(size_t ix = 0; ix < size_t(GetScreenWidth()); ++ix)
-	{
-	    double camera_space_x = app_coordinate_system.transform_to(Vec2<double>{double(ix), 0} - camera.coord_sys.origin, camera.coord_sys).x - camera.origin_offset.x;
-	    double func_y = func->operator()(camera_space_x);
+	for(double func_y : evaluate_at_pixel_columns(*func)) {
 	    max_y = func_y > max_y ? func_y : max_y;
 	    min_y = func_y < min_y ? func_y : min_y;
 	}
     }
 
     if (max_x != -HUGE_VAL && min_x != HUGE_VAL && max_x != min_x) {
-	camera.coord_sys.basis_x = { double(GetScreenWidth() - plot_padding.x * 2) / (max_x - min_x), 0 };
+	camera.coord_sys.basis_x = { double(get_plot_width() - plot_padding.x * 2) / (max_x - min_x), 0 };
 	camera.origin_offset.x = -min_x;
     }
     else {
@@ -469,14 +1101,14 @@ void Data_Manager::fit_camera_to_plot(bool go_to_zero)
     }
     
     if (max_y != -HUGE_VAL && min_y != HUGE_VAL &&  max_y != min_y) {
-	camera.coord_sys.basis_y = { 0, -double(GetScreenHeight() - plot_padding.y * 2) / (max_y - min_y)};
+	camera.coord_sys.basis_y = { 0, -double(get_plot_height() - plot_padding.y * 2) / (max_y - min_y)};
 	camera.origin_offset.y = -min_y;
     }
     else {
-	if (camera.coord_sys.basis_x.x == 0 && camera.coord_sys.basis_x.y == 0) {
+	if (camera.coord_sys.basis_y.x == 0 && camera.coord_sys.basis_y.y == 0) {
 	    camera.coord_sys.basis_y = { 0, -1};
 	}
-	camera.origin_offset.x = 0;
+	camera.origin_offset.y = 0;
     }
 
     if (go_to_zero) {
@@ -486,30 +1118,14 @@ void Data_Manager::fit_camera_to_plot(bool go_to_zero)
 
 void Data_Manager::fit_camera_to_plot(Plot_Data *plot_data)
 {
-    camera.coord_sys.origin = {double(plot_padding.x), double(GetScreenHeight() - plot_padding.y)};
+    camera.coord_sys.origin = {double(plot_padding.x), double(get_plot_height() - plot_padding.y)};
     
     double max_x = -HUGE_VAL, max_y = -HUGE_VAL, min_x = HUGE_VAL, min_y = HUGE_VAL;
 
-    if (plot_data->x) {
-	for(double val : plot_data->x->y) {
-	    max_x = val > max_x ? val : max_x;
-	    min_x = val < min_x ? val : min_x;
-	}
-    }
-    else {
-	for(size_t i = 0; i < plot_data->size(); ++i) {
-	    max_x = i > max_x ? i : max_x;
-	    min_x = i < min_x ? i : min_x;
-	}	    
-    }
-    
-    for(double val : plot_data->y) {
-	max_y = val > max_y ? val : max_y;
-	min_y = val < min_y ? val : min_y;
-    }
+    add_plot_data_bounds(plot_data, 0, plot_data->size(), min_x, max_x, min_y, max_y);
     
-    camera.coord_sys.basis_x = { double(GetScreenWidth() - plot_padding.x * 2) / (max_x - min_x), 0 };
-    camera.coord_sys.basis_y = { 0 , -double(GetScreenHeight() - plot_padding.y * 2) / (max_y - min_y)};
+    camera.coord_sys.basis_x = { double(get_plot_width() - plot_padding.x * 2) / (max_x - min_x), 0 };
+    camera.coord_sys.basis_y = { 0 , -double(get_plot_height() - plot_padding.y * 2) / (max_y - min_y)};
     camera.origin_offset = { -min_x, -min_y };
 }
 
@@ -517,18 +1133,60 @@ void Data_Manager::fit_camera_to_plot(Function* func)
 {
     double max_y = -HUGE_VAL, min_y = HUGE_VAL;
 
-    for(size_t ix = 0; ix < size_t(GetScreenWidth()); ++ix)
-    {
-	double camera_space_x = app_coordinate_system.transform_to(Vec2<double>{double(ix), 0} - camera.coord_sys.origin, camera.coord_sys).x - camera.origin_offset.x;
-	double func_y = func->operator()(camera_space_x);
+    for(double func_y : evaluate_at_pixel_columns(*func)) {
 	max_y = func_y > max_y ? func_y : max_y;
 	min_y = func_y < min_y ? func_y : min_y;
     }
     
-    camera.coord_sys.basis_y = { 0 , -double(GetScreenHeight() - plot_padding.y * 2) / (max_y - min_y)};
+    camera.coord_sys.basis_y = { 0 , -double(get_plot_height() - plot_padding.y * 2) / (max_y - min_y)};
     camera.origin_offset.y = -min_y;
 }
 
+// only the Y axis, to the samples and functions in the visible X range.
+void Data_Manager::fit_camera_y_to_visible_range()
+{
+    double visible_min_x, visible_max_x;
+    get_visible_x_range(camera, visible_min_x, visible_max_x);
+    double max_y = -HUGE_VAL, min_y = HUGE_VAL;
+    double unused_min_x = HUGE_VAL, unused_max_x = -HUGE_VAL;
+    std::vector<X_Index_Range> visible_ranges;
+
+    for(const auto& pd : plot_data) {
+	if (!pd->info.visible || pd->size() == 0)
+	    continue;
+
+	visible_ranges.clear();
+	if (!pd->x) {
+	    size_t begin = size_t(std::clamp(std::ceil(visible_min_x), 0.0, double(pd->size())));
+	    size_t end = size_t(std::clamp(std::floor(visible_max_x) + 1, 0.0, double(pd->size())));
+	    visible_ranges.push_back({begin, end});
+	}
+	else {
+	    pd->x->x_index.update(pd->x->y, pd->x->data_version);
+	    pd->x->x_index.get_visible_ranges(pd->x->y, pd->size(), visible_min_x, visible_max_x, visible_ranges);
+	}
+
+	for (const X_Index_Range& range : visible_ranges)
+	    add_plot_data_bounds(pd, range.begin, range.end, unused_min_x, unused_max_x, min_y, max_y);
+    }
+
+    for(const auto& func : functions) {
+	if (!func->info.visible)
+	    continue;
+
+	for(double func_y : evaluate_at_pixel_columns(*func)) {
+	    max_y = func_y > max_y ? func_y : max_y;
+	    min_y = func_y < min_y ? func_y : min_y;
+	}
+    }
+
+    if (max_y != -HUGE_VAL && min_y != HUGE_VAL && max_y != min_y) {
+	camera.coord_sys.origin.y = double(get_plot_height() - plot_padding.y);
+	camera.coord_sys.basis_y = { 0, -double(get_plot_height() - plot_padding.y * 2) / (max_y - min_y)};
+	camera.origin_offset.y = -min_y;
+    }
+}
+
 // quadratic, only use when actually necessary
 void Data_Manager::update_references()
 {
@@ -555,7 +1213,7 @@ void Data_Manager::update_element_indices()
     }
 }
 
-static bool get_valid_file_name_and_ensure_directory(std::string& file_name)
+static bool get_valid_file_name_and_ensure_directory(std::string& file_name, const std::string& file_type = EXPORT_FILE_TYPE)
 {
     if (!(std::filesystem::exists(EXPORT_DIRECTORY))) {
         if (!(std::filesystem::create_directory(EXPORT_DIRECTORY))) {
@@ -566,18 +1224,24 @@ static bool get_valid_file_name_and_ensure_directory(std::string& file_name)
     
     file_name = EXPORT_DIRECTORY + file_name;
     std::string orig_file_name = file_name;
-    file_name += EXPORT_FILE_TYPE;
+    file_name += file_type;
     
     int file_idx = 1;
     while (file_exists(file_name)) {
-	file_name = orig_file_name + "(" + std::to_string(file_idx) + ")" EXPORT_FILE_TYPE;
+	file_name = orig_file_name + "(" + std::to_string(file_idx) + ")" + file_type;
 	++file_idx;
     }
     return true;
 }
 
-void Data_Manager::export_plot_data(std::string file_name, std::vector<Plot_Data*>& plot_data)
+void Data_Manager::export_plot_data(std::string file_name, std::vector<Plot_Data*>& plot_data, Export_Format format)
 {
+    if (format != EF_TEXT) {
+	if (get_valid_file_name_and_ensure_directory(file_name, PLOT_FILE_EXTENSION))
+	    write_plot_file(file_name, plot_data, format == EF_BINARY_FLOAT ? PFVT_FLOAT : PFVT_DOUBLE);
+	return;
+    }
+    
     if (!get_valid_file_name_and_ensure_directory(file_name))
 	return;
     
@@ -631,9 +1295,10 @@ void Data_Manager::export_functions(std::string file_name, std::vector<Function*
 Plot_Data *get_new_default_x_for_plot_data(Plot_Data *plot_data)
 {
     Plot_Data* new_x = new Plot_Data;
-    new_x->y.resize(plot_data->y.size());
-    for (size_t i = 0; i < new_x->size(); ++i) {
-	new_x->y[i] = i;
+    std::vector<double>& x = new_x->y.edit();
+    x.resize(plot_data->y.size());
+    for (size_t i = 0; i < x.size(); ++i) {
+	x[i] = i;
     }
     return new_x;
 }
@@ -2,11 +2,22 @@
 
 #include "raylib.h"
 
+#include <chrono>
+#include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
 #include "gui_elements.hpp"
 #include "functions.hpp"
+#include "global_vars.hpp"
+#include "csv_parser.hpp"
+#include "data_column.hpp"
+#include "data_stream.hpp"
+#include "plot_lod.hpp"
+#include "plot_renderer.hpp"
+#include "plot_x_index.hpp"
+#include "thread_pool.hpp" // used by the fit worker, so it has to outlive the data_manager
 
 constexpr int graph_color_array_cnt = 20;
 inline Color graph_color_array[graph_color_array_cnt] = {
@@ -35,10 +46,14 @@ inline Color graph_color_array[graph_color_array_cnt] = {
 struct Plot_Data
 {
     Plot_Info info;
-    std::vector<double> y;
+    Data_Column y;
     Content_Tree_Element content_element;
     std::vector<Plot_Data*> x_referencees;
     size_t index = 0;
+    Plot_LOD lod;
+    Plot_Renderer renderer;
+    Plot_X_Index x_index; // only built, if the data is used as X
+    uint64_t data_version = 0;
     
     size_t size() const
     {
@@ -48,6 +63,7 @@ struct Plot_Data
     };
 
     void update_content_tree_element(size_t index);
+    void modified() { ++data_version; g_frame_dirty = true; } // must be called after changing y, so cached representations are rebuilt.
     Plot_Data* x = nullptr;
 };
 
@@ -81,6 +97,35 @@ struct VP_Camera
     Vec2<double> origin_offset = {0, 0};
 
     bool is_undefined() { return coord_sys.basis_x.length() == 0 || coord_sys.basis_y.length() == 0; }
+    bool operator ==(const VP_Camera& other) const
+    {
+	return coord_sys.origin == other.coord_sys.origin && coord_sys.basis_x == other.coord_sys.basis_x
+	    && coord_sys.basis_y == other.coord_sys.basis_y && origin_offset == other.origin_offset;
+    }
+};
+
+// Reverting restores the closest checkpoint before the command and replays only the commands after it.
+// A checkpoint is taken, once replaying the commands since the last one would take this long.
+constexpr double UNDO_CHECKPOINT_SECONDS = 0.2;
+// Above this many bytes of values only kept by checkpoints, the checkpoint which adds the least replay time is dropped.
+// Checkpoints share the values with the data, until they are changed.
+constexpr size_t UNDO_CHECKPOINT_MEMORY = size_t(1) << 30;
+
+// The data and functions after executing the command at command_idx, -1 for the state after loading the last file.
+struct Undo_Checkpoint
+{
+    int64_t command_idx = -1;
+    std::vector<Plot_Data*> plot_data;
+    std::vector<Function*> functions;
+    int graph_color_array_idx = 0;
+    double replay_seconds = 0; // for replaying the commands since the previous checkpoint
+};
+
+enum Export_Format
+{
+    EF_TEXT,
+    EF_BINARY,       // PLOT_FILE_EXTENSION with doubles
+    EF_BINARY_FLOAT, // PLOT_FILE_EXTENSION with floats
 };
 
 struct Data_Manager
@@ -97,53 +142,146 @@ struct Data_Manager
     void update_content_tree(Content_Tree& content_tree);
     void draw();
     void load_external_plot_data(const std::string& file_name);
+    void load_external_plot_data_async(const std::string& file_name);
+    void cancel_loading();
+    void run_script_after_loading(const std::string& file_name); // runs it at once, if no file is loading
+    bool is_loading() const { return csv_loader.is_active() || !loading_queue.empty(); }
+    void start_fit(Function* function, Plot_Data* data, const std::vector<double*>& param_list, int iterations);
+    void finish_fit();
+    void cancel_fit();
+    bool is_fitting() const { return fitting_function; }
     Plot_Data* new_plot_data(Plot_Data* data = nullptr);
     void delete_plot_data(Plot_Data *data);
     Function* new_function(Function* function = nullptr);
     void delete_function(Function *function);
     Function* change_function_type(Function *orig_func, Function* new_func);
+    void fit_camera_to_plot(bool go_to_zero = false);
     void fit_camera_to_plot(Plot_Data* plot_data);
     void fit_camera_to_plot(Function* func);
     void zero_coord_sys_origin();
     void update_references();
-    void export_plot_data(std::string file_name, std::vector<Plot_Data*>& plot_data);
+    void export_plot_data(std::string file_name, std::vector<Plot_Data*>& plot_data, Export_Format format = EF_TEXT);
     void export_functions(std::string file_name, std::vector<Function*>& functions);
     void revert_command();
     void revert_reverting();
+    // called around every command which is added to the command list.
+    void discard_redo_checkpoints();
+    void command_executed(double seconds);
+    // for a command which leaves a fit running, command_executed is called once the fit is done.
+    void fit_command_executed(double seconds);
+    void unload_gpu_resources();
     
     void update_value_data(size_t data_idx, size_t value_idx, double value)
     {
 	if (data_idx < plot_data.size()) {
-	    plot_data[data_idx]->y.at(value_idx) = value;
+	    Plot_Data* pd = plot_data[data_idx];
+	    if (value_idx >= pd->y.size()) {
+		logger.log_error("The value index '%zu' is past the end of data %zu with %zu values.", value_idx, data_idx, pd->y.size());
+		return;
+	    }
+	    pd->y.edit_window()[value_idx] = value;
+	    pd->lod.update_value(pd->y, value_idx);
+	    pd->x_index.update_value(pd->y, value_idx);
+	    pd->renderer.update_value(pd, value_idx);
+	    for (Plot_Data* referencee : pd->x_referencees)
+		referencee->renderer.update_value(referencee, value_idx);
+	    g_frame_dirty = true;
 	}
     }
     
     void resize_data(size_t data_idx, size_t size, double fill_value)
     {
 	if (data_idx < plot_data.size()) {
-	    plot_data[data_idx]->y.resize(size, fill_value);
+	    Plot_Data* pd = plot_data[data_idx];
+	    if (size < pd->y.size())
+		pd->modified();
+	    pd->y.edit().resize(size, fill_value);
+	    if (pd->y.apply_capacity())
+		pd->modified();
+	    pd->lod.append(pd->y);
+	    pd->x_index.append(pd->y);
+	    g_frame_dirty = true;
 	}
     }
     
     void append_data(size_t data_idx, double value)
     {
-	plot_data[data_idx]->y.push_back(value);
+	append_values(plot_data[data_idx], std::span<const double>(&value, 1));
+    }
+
+    void append_data(size_t data_idx, std::span<const double> values)
+    {
+	if (data_idx < plot_data.size())
+	    append_values(plot_data[data_idx], values);
     }
+
+    // bulk access of the library API, the values are copied, except for adopted views.
+    size_t add_data(Data_Column values, const std::string& header);
+    void set_data(size_t data_idx, Data_Column values);
+    void update_data_block(size_t data_idx, size_t value_idx, std::span<const double> values);
+    void set_data_x(size_t data_idx, size_t x_data_idx);
+
+    // rolling window of the last capacity values, 0 for no limit (see Data_Column).
+    void set_capacity(Plot_Data* pd, size_t capacity)
+    {
+	if (pd->y.set_capacity(capacity))
+	    pd->modified();
+    }
+
+    // the streams are drained into their data every frame, until they are closed.
+    FPlot::Data_Stream* open_stream(size_t data_idx, size_t capacity);
+    void close_stream(FPlot::Data_Stream* stream);
+    bool is_streaming() const { return !streams.empty(); }
     
 private:
 
     int graph_color_array_idx = 0;
     const int key_board_lock_id;
 
-    std::vector<Plot_Data*> original_plot_data;
-    std::vector<Function*> original_functions;
-    int original_graph_color_array_idx = 0;
+    std::vector<Undo_Checkpoint> undo_checkpoints; // by command_idx, the first is the state after loading
+    double seconds_since_checkpoint = 0;           // replay time from the last checkpoint to the current command
 
-    void copy_data_to_data(std::vector<Plot_Data*>& from_plot_data, std::vector<Plot_Data*>& to_plot_data,
-			   std::vector<Function*>& from_functions, std::vector<Function*>& to_functions);
+    // background loading of dropped files
+    Csv_Loader csv_loader;
+    std::vector<std::string> loading_queue;
+    std::vector<std::string> script_queue; // scripts dropped while loading, they run once all files are loaded
+    std::vector<Plot_Data*> loading_data; // the columns of the file, nullptr if deleted while loading
+    Content_Tree_Element loading_element;
+    VP_Camera loading_camera; // the camera is fitted to the loaded data, until the user moves it
 
-    void fit_camera_to_plot(bool go_to_zero = false);
+    void update_loading();
+    void finish_loading(const std::string& file_name);
+
+    // fit running in the background, its progress is copied into fitting_function every frame
+    Fit_Worker fit_worker;
+    Function* fitting_function = nullptr;
+    double fit_command_seconds = -1; // of the command which started the fit, if it waits for the fit
+    std::chrono::steady_clock::time_point fit_begin_time;
+
+    void update_fitting();
+    void copy_fit_progress();
+
+    // values which other threads append to data
+    std::vector<std::unique_ptr<FPlot::Data_Stream>> streams;
+    std::vector<double> stream_values;
+
+    void append_values(Plot_Data* pd, std::span<const double> values);
+    void update_streams();
+    void drain_stream(FPlot::Data_Stream& stream);
+
+    void copy_data_to_data(const std::vector<Plot_Data*>& from_plot_data, std::vector<Plot_Data*>& to_plot_data,
+			   const std::vector<Function*>& from_functions, std::vector<Function*>& to_functions);
+    void add_undo_checkpoint();
+    void delete_undo_checkpoint(size_t idx);
+    size_t get_undo_checkpoint_memory() const;
+    void restore_undo_checkpoint(int64_t command_idx);
+
+    void fit_camera_y_to_visible_range();
     void draw_plot_data();
+    void draw_plot_data_range(Plot_Data* pd, size_t begin, size_t end, int plot_type_mask = ~0);
+    void draw_plot_data_decimated(Plot_Data* pd, int lod_level, size_t begin, size_t end);
+    double screen_x_to_camera_x(double screen_x) const;
+    std::vector<double> evaluate_at_pixel_columns(const Function& func) const;
     void draw_functions();
     void update_element_indices();
     bool keyboard_access();
@@ -0,0 +1,41 @@
+#include "data_stream.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace FPlot
+{
+    Data_Stream::Data_Stream(size_t data_idx, size_t capacity)
+	: buffer(std::bit_ceil(std::max(capacity, size_t(1)))), data_idx(data_idx) {}
+
+    // the values are written before head is released, so the consumer never sees a value before it is complete.
+    size_t Data_Stream::push(std::span<const double> values)
+    {
+	const size_t h = head.load(std::memory_order_relaxed);
+	const size_t free_cnt = buffer.size() - (h - tail.load(std::memory_order_acquire));
+	const size_t cnt = std::min(free_cnt, values.size());
+
+	const size_t begin = h & (buffer.size() - 1);
+	const size_t first_cnt = std::min(cnt, buffer.size() - begin);
+	std::copy_n(values.begin(), first_cnt, buffer.begin() + begin);
+	std::copy_n(values.begin() + first_cnt, cnt - first_cnt, buffer.begin());
+	head.store(h + cnt, std::memory_order_release);
+
+	pushed_cnt.fetch_add(cnt, std::memory_order_relaxed);
+	if (cnt < values.size())
+	    dropped_cnt.fetch_add(values.size() - cnt, std::memory_order_relaxed);
+	return cnt;
+    }
+
+    void Data_Stream::pop(std::vector<double>& values)
+    {
+	const size_t t = tail.load(std::memory_order_relaxed);
+	const size_t cnt = head.load(std::memory_order_acquire) - t;
+
+	const size_t begin = t & (buffer.size() - 1);
+	const size_t first_cnt = std::min(cnt, buffer.size() - begin);
+	values.insert(values.end(), buffer.begin() + begin, buffer.begin() + begin + first_cnt);
+	values.insert(values.end(), buffer.begin(), buffer.begin() + (cnt - first_cnt));
+	tail.store(t + cnt, std::memory_order_release);
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace FPlot
+{
+    constexpr size_t DATA_STREAM_DEFAULT_CAPACITY = size_t(1) << 20;
+
+    // Lock free ring buffer from one producer thread to the thread which runs the frames, which appends the values to a
+    // data object once per frame (see Faster_Plot::open_stream). If the frames fall behind and the buffer is full, the
+    // values which do not fit are dropped and counted.
+    class Data_Stream
+    {
+    public:
+
+	Data_Stream(size_t data_idx, size_t capacity);
+
+	// producer, returns the number of values which were not dropped.
+	size_t push(std::span<const double> values);
+	bool push(double value) { return push(std::span<const double>(&value, 1)) == 1; }
+
+	uint64_t get_pushed_cnt() const { return pushed_cnt.load(std::memory_order_relaxed); }
+	uint64_t get_dropped_cnt() const { return dropped_cnt.load(std::memory_order_relaxed); }
+
+	// consumer, appends all values which were pushed so far to values.
+	void pop(std::vector<double>& values);
+	void drop(uint64_t cnt) { dropped_cnt.fetch_add(cnt, std::memory_order_relaxed); }
+	size_t get_data_idx() const { return data_idx; }
+
+    private:
+
+	std::vector<double> buffer; // the size is a power of two
+	size_t data_idx;
+
+	// the indices only grow, the position in the buffer is the index modulo its size.
+	alignas(64) std::atomic<size_t> head = 0; // written by the producer
+	alignas(64) std::atomic<size_t> tail = 0; // written by the consumer
+	alignas(64) std::atomic<uint64_t> pushed_cnt = 0;
+	std::atomic<uint64_t> dropped_cnt = 0;
+    };
+}
@@ -1,5 +1,9 @@
 #include "faster_plot.hpp"
 
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
 #include "data_manager.hpp"
 #include "raylib.h"
 
@@ -9,6 +13,8 @@
 #include "..\resources\font.hpp"
 #include "utils.hpp"
 #include "command_parser.hpp"
+#include "plot_image.hpp"
+#include "object_operations.hpp"
 
 namespace FPlot {
 
@@ -29,8 +35,17 @@ namespace FPlot {
 	g_app_font_20 = LoadFontFromMemory(".ttf", resources_Roboto_Regular_ttf, resources_Roboto_Regular_ttf_len, 20, nullptr, 0);
 	g_app_font_22 = LoadFontFromMemory(".ttf", resources_Roboto_Regular_ttf, resources_Roboto_Regular_ttf_len, 22, nullptr, 0);
     }
+
+    void Faster_Plot::init_headless(int width, int height)
+    {
+	SetTraceLogLevel(LOG_NONE);
+	g_headless_screen_size = {width, height};
+
+	// only the font of the plot is needed, without an OpenGL context it can not be a texture.
+	g_app_font_18 = load_image_font(resources_Roboto_Regular_ttf, resources_Roboto_Regular_ttf_len, 18);
+    }
     
-    void Faster_Plot::run_until_close() { while(app_loop(text_input, content_tree, flags)); }
+    void Faster_Plot::run_until_close() { while(app_loop(text_input, content_tree, flags, true)); }
     bool Faster_Plot::next_frame() { return app_loop(text_input, content_tree, flags); }
     void Faster_Plot::enable_flags(Faster_Plot_flags flags) { this->flags = add_flag(this->flags, flags); }
     void Faster_Plot::disable_flags(Faster_Plot_flags flags) { this->flags = remove_flag(this->flags, flags); }
@@ -46,18 +61,105 @@ namespace FPlot {
 	lexer.tokenize();
 	handle_command(lexer);
     }
+
+    bool Faster_Plot::run_script(std::string file_name)
+    {
+	size_t error_cnt = logger.error_cnt;
+	run_command_file_absolute_path(file_name);
+	return error_cnt == logger.error_cnt;
+    }
+
+    bool Faster_Plot::load_file(std::string file_name)
+    {
+	size_t error_cnt = logger.error_cnt;
+	data_manager.load_external_plot_data(file_name);
+	return error_cnt == logger.error_cnt;
+    }
+
+    bool Faster_Plot::render(std::string file_name, int width, int height) { return render_plot_image(file_name, width, height); }
     
     void Faster_Plot::update_data(size_t data_idx, size_t value_idx, double value) { data_manager.update_value_data(data_idx, value_idx, value); }
     void Faster_Plot::resize_data(size_t data_idx, size_t size, double fill_value) { data_manager.resize_data(data_idx, size, fill_value); }
     void Faster_Plot::append_data(size_t data_idx, double value) { data_manager.append_data(data_idx, value); }
+    void Faster_Plot::append_data(size_t data_idx, std::span<const double> values) { data_manager.append_data(data_idx, values); }
+    void Faster_Plot::set_data(size_t data_idx, std::span<const double> values) { data_manager.set_data(data_idx, std::vector<double>(values.begin(), values.end())); }
+    void Faster_Plot::update_data(size_t data_idx, size_t value_idx, std::span<const double> values) { data_manager.update_data_block(data_idx, value_idx, values); }
+    void Faster_Plot::set_x(size_t data_idx, size_t x_data_idx) { data_manager.set_data_x(data_idx, x_data_idx); }
+    size_t Faster_Plot::add_data(std::span<const double> values, std::string header) { return data_manager.add_data(std::vector<double>(values.begin(), values.end()), header); }
+
+    size_t Faster_Plot::adopt_data(const double* values, size_t size, std::function<void()> release, std::string header)
+    {
+	// the view owner calls release, once the last copy of the column is gone.
+	std::shared_ptr<const void> owner(values, [release = std::move(release)](const void*) { if (release) release(); });
+	return data_manager.add_data(Data_Column::view(std::move(owner), values, size), header);
+    }
+
+    Data_Stream* Faster_Plot::open_stream(size_t data_idx, size_t capacity) { return data_manager.open_stream(data_idx, capacity); }
+    void Faster_Plot::close_stream(Data_Stream* stream) { data_manager.close_stream(stream); }
 }
 
 #if !FASTER_PLOT_LIBRARY
 
-int main()
+static void log_usage()
+{
+    printf("usage: faster_plot [--input file]... [--script file]... [--size width height] [--quiet] [--help]\n"
+	   "  Without arguments the window is opened. Otherwise the inputs (.csv or .fplot) are loaded and the scripts run in order,\n"
+	   "  without a window. The exit code is 0 if everything succeeded, 1 if a file or command failed and 2 for invalid arguments.\n");
+}
+
+// Batch mode, e.g. faster_plot --input data.csv --script analysis.script, for machines without a display.
+static int run_batch(FPlot::Faster_Plot& fplot_handle, int argc, char** argv)
+{
+    std::vector<std::string> input_files;
+    std::vector<std::string> script_files;
+    int width = SCREEN_WIDTH;
+    int height = SCREEN_HEIGHT;
+
+    for (int i = 1; i < argc; ++i) {
+	std::string arg = argv[i];
+	if ((arg == "--input" || arg == "--script") && i + 1 < argc) {
+	    (arg == "--input" ? input_files : script_files).push_back(argv[++i]);
+	}
+	else if (arg == "--size" && i + 2 < argc) {
+	    width = std::atoi(argv[++i]);
+	    height = std::atoi(argv[++i]);
+	    if (width <= 0 || height <= 0) {
+		logger.log_error("Invalid size '%s %s'.", argv[i - 1], argv[i]);
+		return 2;
+	    }
+	}
+	else if (arg == "--quiet") {
+	    fplot_handle.set_log_level(FPlot::LOGLVL_ERROR);
+	}
+	else if (arg == "--help") {
+	    log_usage();
+	    return 0;
+	}
+	else {
+	    logger.log_error("Invalid argument '%s'.", arg.c_str());
+	    log_usage();
+	    return 2;
+	}
+    }
+
+    fplot_handle.init_headless(width, height);
+    bool success = true;
+    for (const std::string& file_name : input_files)
+	success = fplot_handle.load_file(file_name) && success;
+    if (!success)
+	return 1; // the scripts would run on the wrong data
+    for (const std::string& file_name : script_files)
+	success = fplot_handle.run_script(file_name) && success;
+    return success ? 0 : 1;
+}
+
+int main(int argc, char** argv)
 {
     using namespace FPlot;
     Faster_Plot fplot_handle;
+    if (argc > 1)
+	return run_batch(fplot_handle, argc, argv);
+    
     fplot_handle.init_window();
     fplot_handle.enable_flags(Faster_Plot_flags(FPL_CONTENT_TREE | FPL_TEXT_INPUT));
     fplot_handle.run_until_close();
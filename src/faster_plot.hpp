@@ -1,8 +1,12 @@
 #pragma once
 
 #include <cstddef>
+#include <functional>
+#include <span>
 #include <string>
 
+#include "data_stream.hpp"
+
 namespace FPlot
 {
     enum Faster_Plot_flags
@@ -25,15 +29,34 @@ namespace FPlot
     public:
 	
 	void init_window();
+	// Without a window, the plot is only rendered into image files (see render), with the size of a window of width x height.
+	void init_headless(int width = 800, int height = 600);
 	void enable_flags(Faster_Plot_flags flags);
 	void disable_flags(Faster_Plot_flags flags);
         void set_log_level(Log_Level log_level);
 	void run_until_close();                                                // keeps the plot window open, until it is closed by the user.
 	bool next_frame();                                                     // advance the window by one frame.
 	void run_command(std::string cmd);                                     // run any command
+	bool run_script(std::string file_name);                                // run a command script, returns false if any command failed.
+	bool load_file(std::string file_name);                                 // load a .csv or .fplot file, before returning.
+	bool render(std::string file_name, int width, int height);             // render the current view into an image file, the size is limited to 1..16384.
 	void update_data(size_t data_idx, size_t value_idx, double value);     // change a single value of a data object.
 	void resize_data(size_t data_idx, size_t size, double fill_value = 0); // resize a data object.
 	void append_data(size_t data_idx, double value);                       // add a new element at the end of a data object.
+	void append_data(size_t data_idx, std::span<const double> values);    // add new elements at the end of a data object.
+	void set_data(size_t data_idx, std::span<const double> values);       // replace all elements of a data object.
+	void update_data(size_t data_idx, size_t value_idx, std::span<const double> values); // replace the elements from value_idx on, may extend the data.
+	void set_x(size_t data_idx, size_t x_data_idx);                        // plot a data object over another one.
+	size_t add_data(std::span<const double> values, std::string header = ""); // new data object with a copy of the values, returns its index.
+
+	// New data object which reads the values in place, without copying them. They have to stay valid and unchanged until
+	// release is called, once no data object (or reverting state) uses them anymore. Changing the data copies the values first.
+	size_t adopt_data(const double* values, size_t size, std::function<void()> release, std::string header = "");
+
+	// The functions above must be called from the thread which calls next_frame. Other threads stream values into a data
+	// object through a Data_Stream, one thread per stream. The values are appended at the next frame.
+	Data_Stream* open_stream(size_t data_idx, size_t capacity = DATA_STREAM_DEFAULT_CAPACITY);
+	void close_stream(Data_Stream* stream); // appends the remaining values, the producer must be done with the stream.
 	
     private:
 	
@@ -0,0 +1,363 @@
+#include "fft.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+#include "thread_pool.hpp"
+#include "utils.hpp"
+
+// larger prime factors are transformed by Bluestein's algorithm, the generic butterfly needs O(p) per value.
+constexpr size_t FFT_MAX_RADIX = 31;
+constexpr size_t FFT_PLAN_CACHE_SIZE = 4;
+constexpr size_t FFT_PARALLEL_SIZE = 1 << 16;
+
+using Complex = std::complex<double>;
+
+struct Fft_Plan
+{
+    size_t n = 0;
+    std::vector<Complex> twiddles; // exp(-2 pi i k / n), conjugated for the inverse
+    std::vector<size_t> factors;   // pairs of the radix and the size of the sub transforms
+    std::vector<std::vector<Complex>> stage_twiddles; // of the radix 2 and 4 butterflies of a factor, in the order they are used
+    bool bluestein = false;
+};
+
+// Splits off factors of 4 first, as they have the fastest butterfly.
+static bool factorize(size_t n, std::vector<size_t>& factors)
+{
+    size_t p = 4;
+    size_t max_p = size_t(std::sqrt(double(n)));
+    do {
+	while (n % p != 0) {
+	    switch (p) {
+	    case 4: p = 2; break;
+	    case 2: p = 3; break;
+	    default: p += 2; break;
+	    }
+	    if (p > max_p)
+		p = n;
+	}
+	if (p > FFT_MAX_RADIX)
+	    return false;
+	n /= p;
+	factors.push_back(p);
+	factors.push_back(n);
+    } while (n > 1);
+    return true;
+}
+
+// The plans of the last sizes are kept, since the twiddles cost more than a transform of a power of two.
+static std::shared_ptr<const Fft_Plan> get_plan(size_t n)
+{
+    thread_local std::vector<std::shared_ptr<const Fft_Plan>> cache;
+    for (const auto& plan : cache) {
+	if (plan->n == n)
+	    return plan;
+    }
+
+    auto plan = std::make_shared<Fft_Plan>();
+    plan->n = n;
+    plan->bluestein = !factorize(n, plan->factors);
+    if (!plan->bluestein) {
+	plan->twiddles.resize(n);
+	for (size_t k = 0; k < n; ++k)
+	    plan->twiddles[k] = std::polar(1.0, -2 * UTILS_PI * double(k) / double(n));
+
+	// the twiddles of a stage are spread over the whole table, copying them next to each other saves the cache misses.
+	size_t fstride = 1;
+	for (size_t i = 0; i < plan->factors.size(); i += 2) {
+	    size_t p = plan->factors[i];
+	    size_t m = plan->factors[i + 1];
+	    std::vector<Complex> stage;
+	    if (p == 2 || p == 4) {
+		for (size_t k = 0; k < m; ++k)
+		    for (size_t j = 1; j < p; ++j)
+			stage.push_back(plan->twiddles[j * k * fstride]);
+	    }
+	    plan->stage_twiddles.push_back(std::move(stage));
+	    fstride *= p;
+	}
+    }
+
+    if (cache.size() == FFT_PLAN_CACHE_SIZE)
+	cache.erase(cache.begin());
+    cache.push_back(plan);
+    return plan;
+}
+
+// without the NaN and infinity handling of std::complex, which is not inlined by every compiler.
+static inline Complex multiply(Complex a, Complex b)
+{
+    return Complex(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+}
+
+static inline Complex get_twiddle(const Complex& twiddle, bool inverse)
+{
+    return inverse ? std::conj(twiddle) : twiddle;
+}
+
+static void butterfly_2(const Complex* twiddles, Complex* out, size_t m, bool inverse)
+{
+    for (size_t k = 0; k < m; ++k) {
+	Complex t = multiply(out[k + m], get_twiddle(twiddles[k], inverse));
+	out[k + m] = out[k] - t;
+	out[k] += t;
+    }
+}
+
+static void butterfly_4(const Complex* twiddles, Complex* out, size_t m, bool inverse)
+{
+    for (size_t k = 0; k < m; ++k) {
+	Complex s0 = multiply(out[k + m], get_twiddle(twiddles[3 * k], inverse));
+	Complex s1 = multiply(out[k + 2 * m], get_twiddle(twiddles[3 * k + 1], inverse));
+	Complex s2 = multiply(out[k + 3 * m], get_twiddle(twiddles[3 * k + 2], inverse));
+	Complex s5 = out[k] - s1;
+	out[k] += s1;
+	Complex s3 = s0 + s2;
+	Complex s4 = s0 - s2;
+	out[k + 2 * m] = out[k] - s3;
+	out[k] += s3;
+	Complex s4_rotated = inverse ? Complex(-s4.imag(), s4.real()) : Complex(s4.imag(), -s4.real()); // -+ i * s4
+	out[k + m] = s5 + s4_rotated;
+	out[k + 3 * m] = s5 - s4_rotated;
+    }
+}
+
+static void butterfly_generic(const Fft_Plan& plan, Complex* out, size_t fstride, size_t m, size_t p, bool inverse)
+{
+    Complex scratch[FFT_MAX_RADIX];
+    for (size_t u = 0; u < m; ++u) {
+	for (size_t q = 0; q < p; ++q)
+	    scratch[q] = out[u + q * m];
+
+	for (size_t q1 = 0, k = u; q1 < p; ++q1, k += m) {
+	    size_t twiddle_idx = 0;
+	    out[k] = scratch[0];
+	    for (size_t q = 1; q < p; ++q) {
+		twiddle_idx += fstride * k;
+		if (twiddle_idx >= plan.n)
+		    twiddle_idx -= plan.n;
+		out[k] += multiply(scratch[q], get_twiddle(plan.twiddles[twiddle_idx], inverse));
+	    }
+	}
+    }
+}
+
+static void combine(const Fft_Plan& plan, Complex* out, size_t fstride, size_t stage, bool inverse)
+{
+    size_t p = plan.factors[2 * stage];
+    size_t m = plan.factors[2 * stage + 1];
+    switch (p) {
+    case 2: butterfly_2(plan.stage_twiddles[stage].data(), out, m, inverse); break;
+    case 4: butterfly_4(plan.stage_twiddles[stage].data(), out, m, inverse); break;
+    default: butterfly_generic(plan, out, fstride, m, p, inverse); break;
+    }
+}
+
+// decimation in time: the p sub transforms of every p-th value, then the butterflies combine them.
+static void fft_work(const Fft_Plan& plan, Complex* out, const Complex* in, size_t fstride, size_t stage, bool inverse)
+{
+    size_t p = plan.factors[2 * stage];
+    size_t m = plan.factors[2 * stage + 1];
+    if (m == 1) {
+	for (size_t q = 0; q < p; ++q)
+	    out[q] = in[q * fstride];
+    }
+    else {
+	for (size_t q = 0; q < p; ++q)
+	    fft_work(plan, out + q * m, in + q * fstride, fstride * p, stage + 1, inverse);
+    }
+
+    combine(plan, out, fstride, stage, inverse);
+}
+
+// The transform as a convolution with a chirp, which is computed by transforms of a power of two.
+static void bluestein(std::vector<Complex>& values, bool inverse)
+{
+    const size_t n = values.size();
+    size_t m = 1;
+    while (m < 2 * n - 1)
+	m *= 2;
+
+    std::vector<Complex> chirp(n);
+    for (size_t k = 0; k < n; ++k) {
+	double angle = UTILS_PI * double((k * k) % (2 * n)) / double(n); // the remainder keeps the angle exact
+	chirp[k] = std::polar(1.0, inverse ? angle : -angle);
+    }
+
+    std::vector<Complex> a(m, 0.0);
+    std::vector<Complex> b(m, 0.0);
+    for (size_t k = 0; k < n; ++k)
+	a[k] = multiply(values[k], chirp[k]);
+    b[0] = std::conj(chirp[0]);
+    for (size_t k = 1; k < n; ++k)
+	b[k] = b[m - k] = std::conj(chirp[k]);
+
+    fft(a);
+    fft(b);
+    for (size_t k = 0; k < m; ++k)
+	a[k] = multiply(a[k], b[k]);
+    fft(a, true);
+
+    for (size_t k = 0; k < n; ++k)
+	values[k] = multiply(chirp[k], a[k]) / double(m);
+}
+
+void fft(std::vector<Complex>& values, bool inverse)
+{
+    if (values.size() <= 1)
+	return;
+
+    std::shared_ptr<const Fft_Plan> plan = get_plan(values.size());
+    if (plan->bluestein) {
+	bluestein(values, inverse);
+	return;
+    }
+
+    std::vector<Complex> out(values.size());
+    size_t p = plan->factors[0];
+    size_t m = plan->factors[1];
+    if (values.size() >= FFT_PARALLEL_SIZE && m > 1) {
+	// the sub transforms of the first stage are independent
+	thread_pool.run(p, [&](size_t q) {
+	    fft_work(*plan, out.data() + q * m, values.data() + q, p, 1, inverse);
+	});
+	combine(*plan, out.data(), 1, 0, inverse);
+    }
+    else
+	fft_work(*plan, out.data(), values.data(), 1, 0, inverse);
+    values = std::move(out);
+}
+
+// The even and odd values are the real and imaginary part of a transform of half the size, which are separated after it.
+std::vector<Complex> real_fft(const double* values, size_t n)
+{
+    if (n % 2 == 1 || n < 4) {
+	std::vector<Complex> full(values, values + n);
+	fft(full);
+	full.resize(n / 2 + 1);
+	return full;
+    }
+
+    const size_t half = n / 2;
+    std::vector<Complex> z(half);
+    for (size_t j = 0; j < half; ++j)
+	z[j] = Complex(values[2 * j], values[2 * j + 1]);
+    fft(z);
+
+    std::vector<Complex> spectrum(half + 1);
+    for (size_t k = 0; k <= half; ++k) {
+	Complex z_k = z[k % half];
+	Complex z_mirrored = std::conj(z[(half - k) % half]);
+	Complex even = (z_k + z_mirrored) * 0.5;
+	Complex odd = (z_k - z_mirrored) * 0.5;
+	odd = Complex(odd.imag(), -odd.real()); // / i
+	spectrum[k] = even + multiply(std::polar(1.0, -2 * UTILS_PI * double(k) / double(n)), odd);
+    }
+    return spectrum;
+}
+
+// Both inputs are transformed at once, as the real and imaginary part of one transform.
+std::vector<double> convolve(const double* a, size_t a_size, const double* b, size_t b_size)
+{
+    if (a_size == 0 || b_size == 0)
+	return {};
+
+    const size_t size = a_size + b_size - 1;
+    size_t m = 1;
+    while (m < size)
+	m *= 2;
+
+    std::vector<Complex> z(m, 0.0);
+    for (size_t i = 0; i < a_size; ++i)
+	z[i].real(a[i]);
+    for (size_t i = 0; i < b_size; ++i)
+	z[i].imag(b[i]);
+    fft(z);
+
+    std::vector<Complex> product(m);
+    for (size_t k = 0; k < m; ++k) {
+	Complex z_k = z[k];
+	Complex z_mirrored = std::conj(z[(m - k) % m]);
+	Complex a_k = (z_k + z_mirrored) * 0.5;
+	Complex b_k = (z_k - z_mirrored) * 0.5;
+	b_k = Complex(b_k.imag(), -b_k.real()); // / i
+	product[k] = multiply(a_k, b_k);
+    }
+    fft(product, true);
+
+    std::vector<double> result(size);
+    for (size_t i = 0; i < size; ++i)
+	result[i] = product[i].real() / double(m);
+    return result;
+}
+
+std::vector<double> cross_correlate(const double* a, size_t a_size, const double* b, size_t b_size)
+{
+    std::vector<double> b_reversed(b, b + b_size);
+    std::reverse(b_reversed.begin(), b_reversed.end());
+    return convolve(a, a_size, b_reversed.data(), b_size);
+}
+
+Window_Type get_window_type(std::string_view name)
+{
+    for (int type = 0; type < WINDOW_CNT; ++type) {
+	if (name == window_name_table[type])
+	    return Window_Type(type);
+    }
+    return WINDOW_CNT;
+}
+
+// periodic windows, as they are used for spectral analysis.
+static double get_window_value(Window_Type window, size_t k, size_t n)
+{
+    double phase = 2 * UTILS_PI * double(k) / double(n);
+    switch (window) {
+    case WINDOW_hann: return 0.5 - 0.5 * std::cos(phase);
+    case WINDOW_hamming: return 0.54 - 0.46 * std::cos(phase);
+    case WINDOW_blackman: return 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2 * phase);
+    default: return 1;
+    }
+}
+
+// the bins between 0 and the Nyquist frequency stand for their negative frequency as well.
+static bool is_doubled_bin(size_t k, size_t n)
+{
+    return k > 0 && !(n % 2 == 0 && k == n / 2);
+}
+
+std::vector<double> amplitude_spectrum(const double* values, size_t n)
+{
+    std::vector<Complex> spectrum = real_fft(values, n);
+    std::vector<double> amplitudes(spectrum.size());
+    for (size_t k = 0; k < spectrum.size(); ++k)
+	amplitudes[k] = std::abs(spectrum[k]) / double(n) * (is_doubled_bin(k, n) ? 2 : 1);
+    return amplitudes;
+}
+
+std::vector<double> phase_spectrum(const double* values, size_t n)
+{
+    std::vector<Complex> spectrum = real_fft(values, n);
+    std::vector<double> phases(spectrum.size());
+    for (size_t k = 0; k < spectrum.size(); ++k)
+	phases[k] = std::arg(spectrum[k]);
+    return phases;
+}
+
+std::vector<double> power_spectral_density(const double* values, size_t n, double sample_rate, Window_Type window)
+{
+    std::vector<double> windowed(n);
+    double window_power = 0;
+    for (size_t k = 0; k < n; ++k) {
+	double w = get_window_value(window, k, n);
+	windowed[k] = values[k] * w;
+	window_power += w * w;
+    }
+
+    std::vector<Complex> spectrum = real_fft(windowed.data(), n);
+    std::vector<double> density(spectrum.size());
+    for (size_t k = 0; k < spectrum.size(); ++k)
+	density[k] = std::norm(spectrum[k]) / (sample_rate * window_power) * (is_doubled_bin(k, n) ? 2 : 1);
+    return density;
+}
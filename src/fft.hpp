@@ -0,0 +1,45 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// Discrete Fourier transform of any size, in place. The size is split into the factors 4, 2, 3, 5, ... (mixed radix),
+// sizes with a large prime factor use Bluestein's algorithm on top of it. The inverse is not scaled by 1 / n.
+// Large transforms run on the thread pool, so none of these may be called from a task of it.
+void fft(std::vector<std::complex<double>>& values, bool inverse = false);
+
+// the bins 0 to n / 2 of the transform of n real values, computed by a transform of half the size.
+std::vector<std::complex<double>> real_fft(const double* values, size_t n);
+
+// full linear convolution with a_size + b_size - 1 values.
+std::vector<double> convolve(const double* a, size_t a_size, const double* b, size_t b_size);
+
+// r[l] = sum of a[i + l] * b[i], for the lags l from -(b_size - 1) to a_size - 1.
+std::vector<double> cross_correlate(const double* a, size_t a_size, const double* b, size_t b_size);
+
+enum Window_Type
+{
+    WINDOW_rect,
+    WINDOW_hann,
+    WINDOW_hamming,
+    WINDOW_blackman,
+    WINDOW_CNT
+};
+
+inline const char* window_name_table[WINDOW_CNT] = {
+    "rect",
+    "hann",
+    "hamming",
+    "blackman",
+};
+
+// WINDOW_CNT if there is no window with this name.
+Window_Type get_window_type(std::string_view name);
+
+// One sided spectra of n equally spaced real values, for the frequencies k * sample_rate / n with k from 0 to n / 2.
+// The amplitude of a sine is its peak in the amplitude spectrum, the power spectral density is in value^2 / frequency.
+std::vector<double> amplitude_spectrum(const double* values, size_t n);
+std::vector<double> phase_spectrum(const double* values, size_t n);
+std::vector<double> power_spectral_density(const double* values, size_t n, double sample_rate, Window_Type window);
@@ -0,0 +1,392 @@
+#include "function_fit.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+
+#include "data_manager.hpp"
+#include "functions.hpp"
+#include "thread_pool.hpp"
+#include "utils.hpp"
+
+constexpr double FIT_INITIAL_DAMPING = 1e-3;
+constexpr double FIT_MIN_DAMPING = 1e-12;
+constexpr double FIT_MAX_DAMPING = 1e16;
+constexpr double FIT_COST_TOLERANCE = 1e-12; // relative decrease of the squared error
+constexpr double FIT_STEP_TOLERANCE = 1e-10; // relative change of the parameters
+
+// The samples are reduced in chunks of this size in parallel. The partial sums are combined in the order of the chunks,
+// so the result does not depend on the number of threads.
+constexpr size_t FIT_CHUNK_SIZE = 1 << 14;
+
+// sum of r^2, J^T J and J^T r, for the residuals r = f(x) - y and their Jacobian J (d r / d param).
+struct Normal_Equations
+{
+    double cost = 0;
+    std::vector<double> jtj; // row major
+    std::vector<double> jtr;
+};
+
+Fit_Samples get_fit_samples(Plot_Data* data)
+{
+    Fit_Samples samples;
+    samples.y = data->y;
+    if (data->x)
+	samples.x = data->x->y;
+    return samples;
+}
+
+static size_t get_chunk_cnt(const Fit_Samples& samples)
+{
+    return (samples.size() + FIT_CHUNK_SIZE - 1) / FIT_CHUNK_SIZE;
+}
+
+static void get_x_block(const Fit_Samples& samples, size_t begin, size_t cnt, double* x)
+{
+    if (!samples.x.empty()) {
+	std::copy(samples.x.data() + begin, samples.x.data() + begin + cnt, x);
+    }
+    else {
+	for (size_t i = 0; i < cnt; ++i)
+	    x[i] = double(begin + i);
+    }
+}
+
+static double get_cost(const Fit_Samples& samples, const Function& function)
+{
+    std::vector<Kahan_Sum> chunk_costs(get_chunk_cnt(samples));
+
+    thread_pool.run(chunk_costs.size(), [&](size_t chunk) {
+	double x[FUNCTION_BLOCK_SIZE];
+	double values[FUNCTION_BLOCK_SIZE];
+	size_t chunk_end = std::min(samples.size(), (chunk + 1) * FIT_CHUNK_SIZE);
+
+	for (size_t begin = chunk * FIT_CHUNK_SIZE; begin < chunk_end; begin += FUNCTION_BLOCK_SIZE) {
+	    size_t cnt = std::min(FUNCTION_BLOCK_SIZE, chunk_end - begin);
+	    get_x_block(samples, begin, cnt, x);
+	    function.evaluate_many(x, values, cnt);
+	    const double* y = samples.y.data() + begin;
+	    double sum = 0;
+	    for (size_t i = 0; i < cnt; ++i)
+		sum += (values[i] - y[i]) * (values[i] - y[i]);
+	    chunk_costs[chunk].add(sum);
+	}
+    });
+
+    Kahan_Sum cost;
+    for (const auto& chunk_cost : chunk_costs)
+	cost.add(chunk_cost.get());
+    return cost.get();
+}
+
+double get_squared_error(Plot_Data* data, const Function& function)
+{
+    return get_cost(get_fit_samples(data), function) / double(data->size());
+}
+
+// One pass over the data. Parameters without an analytic derivative are estimated by a central difference, on a copy of
+// the function for every chunk, since the chunks run in parallel.
+static void get_normal_equations(const Fit_Samples& samples, const Function& function, const std::vector<double*>& param_list,
+				 const std::vector<int>& param_indices, Normal_Equations& equations)
+{
+    const size_t m = param_list.size();
+
+    std::vector<bool> analytic(m);
+    bool all_analytic = true;
+    for (size_t k = 0; k < m; ++k) {
+	analytic[k] = function.evaluate_derivative_many(param_list[k], nullptr, nullptr, 0);
+	all_analytic = all_analytic && analytic[k];
+    }
+
+    struct Chunk_Sums
+    {
+	Kahan_Sum cost;
+	std::vector<Kahan_Sum> jtj; // lower triangle
+	std::vector<Kahan_Sum> jtr;
+    };
+    std::vector<Chunk_Sums> chunk_sums(get_chunk_cnt(samples));
+
+    thread_pool.run(chunk_sums.size(), [&](size_t chunk) {
+	double x[FUNCTION_BLOCK_SIZE];
+	double residuals[FUNCTION_BLOCK_SIZE];
+	double lower_values[FUNCTION_BLOCK_SIZE];
+	std::vector<double> jacobian(m * FUNCTION_BLOCK_SIZE); // a column of FUNCTION_BLOCK_SIZE values per parameter
+	Chunk_Sums& sums = chunk_sums[chunk];
+	sums.jtj.resize(m * m);
+	sums.jtr.resize(m);
+	std::unique_ptr<Function> copy(all_analytic ? nullptr : function.clone());
+	size_t chunk_end = std::min(samples.size(), (chunk + 1) * FIT_CHUNK_SIZE);
+
+	for (size_t begin = chunk * FIT_CHUNK_SIZE; begin < chunk_end; begin += FUNCTION_BLOCK_SIZE) {
+	    size_t cnt = std::min(FUNCTION_BLOCK_SIZE, chunk_end - begin);
+	    get_x_block(samples, begin, cnt, x);
+
+	    function.evaluate_many(x, residuals, cnt);
+	    const double* y = samples.y.data() + begin;
+	    double sum = 0;
+	    for (size_t i = 0; i < cnt; ++i) {
+		residuals[i] -= y[i];
+		sum += residuals[i] * residuals[i];
+	    }
+	    sums.cost.add(sum);
+
+	    for (size_t k = 0; k < m; ++k) {
+		double* column = jacobian.data() + k * FUNCTION_BLOCK_SIZE;
+		if (analytic[k]) {
+		    function.evaluate_derivative_many(param_list[k], x, column, cnt);
+		    continue;
+		}
+		double* param = copy->get_parameter_ref(param_indices[k]);
+		double orig_param = *param;
+		double delta = 1e-6 * std::max(std::abs(orig_param), 1.0);
+		*param = orig_param + delta;
+		copy->evaluate_many(x, column, cnt);
+		*param = orig_param - delta;
+		copy->evaluate_many(x, lower_values, cnt);
+		*param = orig_param;
+		for (size_t i = 0; i < cnt; ++i)
+		    column[i] = (column[i] - lower_values[i]) / (2 * delta);
+	    }
+
+	    for (size_t a = 0; a < m; ++a) {
+		const double* column_a = jacobian.data() + a * FUNCTION_BLOCK_SIZE;
+		sum = 0;
+		for (size_t i = 0; i < cnt; ++i)
+		    sum += column_a[i] * residuals[i];
+		sums.jtr[a].add(sum);
+
+		for (size_t b = 0; b <= a; ++b) {
+		    const double* column_b = jacobian.data() + b * FUNCTION_BLOCK_SIZE;
+		    sum = 0;
+		    for (size_t i = 0; i < cnt; ++i)
+			sum += column_a[i] * column_b[i];
+		    sums.jtj[a * m + b].add(sum);
+		}
+	    }
+	}
+    });
+
+    Kahan_Sum cost;
+    std::vector<Kahan_Sum> jtj(m * m);
+    std::vector<Kahan_Sum> jtr(m);
+    for (const auto& sums : chunk_sums) {
+	cost.add(sums.cost.get());
+	for (size_t a = 0; a < m; ++a) {
+	    jtr[a].add(sums.jtr[a].get());
+	    for (size_t b = 0; b <= a; ++b)
+		jtj[a * m + b].add(sums.jtj[a * m + b].get());
+	}
+    }
+
+    equations.cost = cost.get();
+    equations.jtj.assign(m * m, 0);
+    equations.jtr.assign(m, 0);
+    for (size_t a = 0; a < m; ++a) {
+	equations.jtr[a] = jtr[a].get();
+	for (size_t b = 0; b <= a; ++b) {
+	    equations.jtj[a * m + b] = jtj[a * m + b].get();
+	    equations.jtj[b * m + a] = jtj[a * m + b].get();
+	}
+    }
+}
+
+// Solves a * x = b for the symmetric positive definite a by a Cholesky decomposition, b is replaced by x.
+// Returns false if a is not positive definite.
+static bool solve_cholesky(std::vector<double> a, std::vector<double>& b, size_t m)
+{
+    for (size_t j = 0; j < m; ++j) {
+	for (size_t k = 0; k < j; ++k)
+	    a[j * m + j] -= a[j * m + k] * a[j * m + k];
+	if (!(a[j * m + j] > 0))
+	    return false;
+	a[j * m + j] = std::sqrt(a[j * m + j]);
+
+	for (size_t i = j + 1; i < m; ++i) {
+	    for (size_t k = 0; k < j; ++k)
+		a[i * m + j] -= a[i * m + k] * a[j * m + k];
+	    a[i * m + j] /= a[j * m + j];
+	}
+    }
+
+    for (size_t i = 0; i < m; ++i) {
+	for (size_t k = 0; k < i; ++k)
+	    b[i] -= a[i * m + k] * b[k];
+	b[i] /= a[i * m + i];
+    }
+    for (size_t i = m; i-- > 0;) {
+	for (size_t k = i + 1; k < m; ++k)
+	    b[i] -= a[k * m + i] * b[k];
+	b[i] /= a[i * m + i];
+    }
+    return true;
+}
+
+// The covariance of the parameters is (J^T J)^-1 scaled by the variance of the residuals.
+static std::vector<double> get_covariance(const Normal_Equations& equations, size_t n, size_t m)
+{
+    std::vector<double> covariance(m * m, std::numeric_limits<double>::quiet_NaN());
+    if (n <= m)
+	return covariance;
+
+    double variance = equations.cost / double(n - m);
+    std::vector<double> column(m);
+    for (size_t j = 0; j < m; ++j) {
+	std::fill(column.begin(), column.end(), 0.0);
+	column[j] = 1;
+	if (!solve_cholesky(equations.jtj, column, m))
+	    return std::vector<double>(m * m, std::numeric_limits<double>::quiet_NaN());
+	for (size_t i = 0; i < m; ++i)
+	    covariance[i * m + j] = column[i] * variance;
+    }
+    return covariance;
+}
+
+Fit_Result fit_function_to_data(const Fit_Samples& samples, Function& function, const std::vector<double*>& param_list, int max_iterations,
+				const std::function<bool(const Fit_Result&)>& report_progress)
+{
+    Fit_Result result;
+    result.max_iterations = max_iterations;
+    const size_t m = param_list.size();
+    const size_t n = samples.size();
+    if (n == 0 || m == 0)
+	return result;
+
+    std::vector<Parameter_Bounds> bounds(m);
+    for (size_t k = 0; k < m; ++k) {
+	int param_idx = function.get_parameter_ref_idx(param_list[k]);
+	result.param_indices.push_back(param_idx);
+	bounds[k] = function.get_parameter_bounds(param_idx);
+	if (std::isnan(*param_list[k]))
+	    *param_list[k] = 1; // generic parameters are NaN, until they are set
+	*param_list[k] = std::clamp(*param_list[k], bounds[k].lower, bounds[k].upper);
+    }
+
+    Normal_Equations equations;
+    get_normal_equations(samples, function, param_list, result.param_indices, equations);
+
+    double damping = FIT_INITIAL_DAMPING;
+    std::vector<double> orig_params(m);
+    std::vector<double> step(m);
+    auto report = [&]() {
+	if (!report_progress)
+	    return true;
+	result.running = true;
+	result.rms_error = std::sqrt(equations.cost / double(n));
+	bool proceed = report_progress(result);
+	result.running = false;
+	return proceed;
+    };
+    bool canceled = !report();
+
+    while (result.iterations < max_iterations && !result.converged && equations.cost > 0 && !canceled)
+    {
+	++result.iterations;
+	bool improved = false;
+
+	while (!improved && damping < FIT_MAX_DAMPING)
+	{
+	    // (J^T J + damping * diag(J^T J)) * step = -J^T r
+	    std::vector<double> a = equations.jtj;
+	    for (size_t k = 0; k < m; ++k) {
+		a[k * m + k] += damping * std::max(equations.jtj[k * m + k], std::numeric_limits<double>::min());
+		step[k] = -equations.jtr[k];
+	    }
+	    if (!solve_cholesky(a, step, m)) {
+		damping *= 10;
+		continue;
+	    }
+
+	    double max_relative_step = 0;
+	    for (size_t k = 0; k < m; ++k) {
+		orig_params[k] = *param_list[k];
+		*param_list[k] = std::clamp(orig_params[k] + step[k], bounds[k].lower, bounds[k].upper);
+		max_relative_step = std::max(max_relative_step, std::abs(*param_list[k] - orig_params[k]) / (std::abs(orig_params[k]) + FIT_STEP_TOLERANCE));
+	    }
+
+	    double cost = get_cost(samples, function);
+	    if (cost < equations.cost) {
+		improved = true;
+		damping = std::max(damping * 0.1, FIT_MIN_DAMPING);
+		result.converged = equations.cost - cost <= FIT_COST_TOLERANCE * equations.cost || max_relative_step <= FIT_STEP_TOLERANCE;
+		get_normal_equations(samples, function, param_list, result.param_indices, equations);
+	    }
+	    else {
+		for (size_t k = 0; k < m; ++k)
+		    *param_list[k] = orig_params[k];
+		damping *= 10;
+		if (max_relative_step <= FIT_STEP_TOLERANCE) {
+		    result.converged = true;
+		    break;
+		}
+	    }
+	}
+
+	if (!improved) {
+	    result.converged = true; // no step decreases the error anymore
+	}
+
+	canceled = !report();
+    }
+
+    if (equations.cost == 0)
+	result.converged = true;
+
+    result.valid = true;
+    result.rms_error = std::sqrt(equations.cost / double(n));
+    result.covariance = get_covariance(equations, n, m);
+    return result;
+}
+
+Fit_Worker::~Fit_Worker()
+{
+    cancel();
+}
+
+void Fit_Worker::start(const Function& function, Fit_Samples samples, const std::vector<int>& param_indices, int max_iterations)
+{
+    cancel();
+    this->function.reset(function.clone());
+    param_values.clear();
+    result = Fit_Result{};
+    result.running = true;
+    result.max_iterations = max_iterations;
+    result.param_indices = param_indices;
+    cancel_requested = false;
+    finished = false;
+
+    std::vector<double*> param_list;
+    for (int idx : param_indices)
+	param_list.push_back(this->function->get_parameter_ref(idx));
+
+    thread = std::thread([this, samples = std::move(samples), param_list, max_iterations]() {
+	auto publish = [&](const Fit_Result& progress) {
+	    std::lock_guard<std::mutex> lock(mutex);
+	    param_values.clear();
+	    for (double* param : param_list)
+		param_values.push_back(*param);
+	    result = progress;
+	    return !cancel_requested;
+	};
+	publish(fit_function_to_data(samples, *this->function, param_list, max_iterations, publish));
+	finished = true;
+    });
+}
+
+void Fit_Worker::cancel()
+{
+    cancel_requested = true;
+    wait();
+}
+
+void Fit_Worker::wait()
+{
+    if (thread.joinable())
+	thread.join();
+}
+
+void Fit_Worker::get_progress(std::vector<double>& param_values, Fit_Result& result)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    param_values = this->param_values;
+    result = this->result;
+}
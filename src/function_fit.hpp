@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "data_column.hpp"
+
+class Function;
+struct Plot_Data;
+
+struct Parameter_Bounds
+{
+    double lower = -HUGE_VAL;
+    double upper = HUGE_VAL;
+};
+
+// The outcome of the last fit of a function.
+struct Fit_Result
+{
+    bool valid = false;
+    bool running = false; // the fit is still running in the background, there is no covariance yet
+    bool converged = false;
+    int iterations = 0;
+    int max_iterations = 0;
+    double rms_error = 0;
+    std::vector<int> param_indices; // the fitted parameters
+    std::vector<double> covariance; // of the fitted parameters, row major, NaN if the fit is underdetermined
+
+    double get_uncertainty(size_t i) const { return std::sqrt(covariance[i * param_indices.size() + i]); }
+};
+
+// The values which are fitted. The columns are copies (see Data_Column), so the data can be changed while a fit is running.
+struct Fit_Samples
+{
+    Data_Column x; // empty for the index as X
+    Data_Column y;
+
+    size_t size() const { return y.size(); }
+};
+
+Fit_Samples get_fit_samples(Plot_Data* data);
+
+// Levenberg-Marquardt least squares fit of the parameters in param_list (references from Function::get_parameter_ref),
+// which are kept within their bounds. Runs at most max_iterations. report_progress is called after every iteration,
+// the fit is canceled if it returns false.
+Fit_Result fit_function_to_data(const Fit_Samples& samples, Function& function, const std::vector<double*>& param_list, int max_iterations,
+				const std::function<bool(const Fit_Result&)>& report_progress = nullptr);
+
+// mean of the squared residuals, reduced in parallel with a deterministic result.
+double get_squared_error(Plot_Data* data, const Function& function);
+
+// Runs a fit on a background thread, on a copy of the function. The parameters of the copy are published after every
+// iteration, so the progress can be shown while the fit is running.
+class Fit_Worker
+{
+public:
+
+    ~Fit_Worker();
+
+    void start(const Function& function, Fit_Samples samples, const std::vector<int>& param_indices, int max_iterations);
+    void cancel();
+    void wait();
+    bool is_active() const { return thread.joinable(); }
+    bool is_finished() const { return finished; }
+    bool was_canceled() const { return cancel_requested; }
+
+    // the latest parameter values (in the order of param_indices) and state of the fit.
+    void get_progress(std::vector<double>& param_values, Fit_Result& result);
+
+private:
+
+    std::thread thread;
+    std::mutex mutex;
+    std::unique_ptr<Function> function;
+    std::vector<double> param_values;
+    Fit_Result result;
+    std::atomic<bool> cancel_requested = false;
+    std::atomic<bool> finished = false;
+};
@@ -1,5 +1,6 @@
 #include "function_parsing.hpp"
 
+#include <algorithm>
 #include <limits>
 #include <string>
 
@@ -245,7 +246,366 @@ double Function_Op_Tree::evaluate_node(const Generic_Function& generic_function,
     return std::numeric_limits<double>().quiet_NaN();
 }
 
-double Function_Op_Tree::evaluate(const Generic_Function& generic_function, double x) const
+double Function_Op_Tree::evaluate_tree(const Generic_Function& generic_function, double x) const
 {
     return evaluate_node(generic_function, x, base_node);
 }
+
+double Function_Op_Tree::evaluate(const Generic_Function& generic_function, double x) const
+{
+    if (program.empty())
+	return evaluate_node(generic_function, x, base_node);
+
+    const Parameter* params = generic_function.params.data();
+    double stack[FUNCTION_PROGRAM_MAX_STACK_SIZE];
+    int top = -1;
+    
+    for (const Function_Instruction& instruction : program) {
+	switch (instruction.code) {
+	case FOC_const: stack[++top] = instruction.value; break;
+	case FOC_param: stack[++top] = params[instruction.param_idx].val; break;
+	case FOC_x:     stack[++top] = x; break;
+	case FOC_add:   --top; stack[top] = stack[top] + stack[top + 1]; break;
+	case FOC_sub:   --top; stack[top] = stack[top] - stack[top + 1]; break;
+	case FOC_mul:   --top; stack[top] = stack[top] * stack[top + 1]; break;
+	case FOC_div:   --top; stack[top] = stack[top] / stack[top + 1]; break;
+	case FOC_neg:   stack[top] = -stack[top]; break;
+	case FOC_call:  --top; stack[top] = instruction.exe(stack[top], stack[top + 1]); break;
+	}
+    }
+    return stack[0];
+}
+
+void Function_Op_Tree::evaluate_many(const Generic_Function& generic_function, const double* x, double* y, size_t n) const
+{
+    if (program.empty()) {
+	for (size_t i = 0; i < n; ++i)
+	    y[i] = evaluate_node(generic_function, x[i], base_node);
+	return;
+    }
+
+    const Parameter* params = generic_function.params.data();
+    std::vector<double> stack(size_t(program_stack_size) * FUNCTION_BLOCK_SIZE);
+    
+    for (size_t begin = 0; begin < n; begin += FUNCTION_BLOCK_SIZE)
+    {
+	const size_t cnt = std::min(FUNCTION_BLOCK_SIZE, n - begin);
+	double* top = nullptr; // the column of the topmost value
+	double* below = nullptr;
+	size_t top_idx = 0;
+	auto push = [&]() { top = stack.data() + top_idx++ * FUNCTION_BLOCK_SIZE; };
+	auto pop = [&]() { --top_idx; below = stack.data() + (top_idx - 1) * FUNCTION_BLOCK_SIZE; };
+
+	for (const Function_Instruction& instruction : program) {
+	    switch (instruction.code) {
+	    case FOC_const:
+		push();
+		std::fill(top, top + cnt, instruction.value);
+		break;
+	    case FOC_param:
+		push();
+		std::fill(top, top + cnt, params[instruction.param_idx].val);
+		break;
+	    case FOC_x:
+		push();
+		std::copy(x + begin, x + begin + cnt, top);
+		break;
+	    case FOC_add:
+		pop();
+		for (size_t i = 0; i < cnt; ++i) below[i] = below[i] + top[i];
+		top = below;
+		break;
+	    case FOC_sub:
+		pop();
+		for (size_t i = 0; i < cnt; ++i) below[i] = below[i] - top[i];
+		top = below;
+		break;
+	    case FOC_mul:
+		pop();
+		for (size_t i = 0; i < cnt; ++i) below[i] = below[i] * top[i];
+		top = below;
+		break;
+	    case FOC_div:
+		pop();
+		for (size_t i = 0; i < cnt; ++i) below[i] = below[i] / top[i];
+		top = below;
+		break;
+	    case FOC_neg:
+		for (size_t i = 0; i < cnt; ++i) top[i] = -top[i];
+		break;
+	    case FOC_call:
+		pop();
+		for (size_t i = 0; i < cnt; ++i) below[i] = instruction.exe(below[i], top[i]);
+		top = below;
+		break;
+	    }
+	}
+	std::copy(stack.data(), stack.data() + cnt, y + begin);
+    }
+}
+
+void Function_Op_Tree::compile()
+{
+    program.clear();
+    program_stack_size = compile_node(base_node);
+    if (program_stack_size > FUNCTION_PROGRAM_MAX_STACK_SIZE)
+	program.clear();
+}
+
+// appends the program of the node and returns the stack size it needs.
+// Evaluates like evaluate_node: a missing operand of an operation is NaN.
+int Function_Op_Tree::compile_node(Op_Tree_Node* node)
+{
+    auto push_const = [&](double value) {
+	Function_Instruction instruction{FOC_const, {}};
+	instruction.value = value;
+	program.push_back(instruction);
+	return 1;
+    };
+    
+    if (!node)
+	return push_const(std::numeric_limits<double>().quiet_NaN());
+
+    const Semantic_code& tkn_sema = tkn_semantics_table[node->tkn.type];
+
+    if (node->left || node->right)
+    {
+	double (*exe)(EXE_ARGS) = node->left && node->right ? tkn_sema.exe_led : tkn_sema.exe_nud;
+
+	if (!node->left && exe == exe_add_unary)
+	    return compile_node(node->right);
+	
+	size_t left_begin = program.size();
+	int left_stack_size = compile_node(node->left);
+	size_t right_begin = program.size();
+	int right_stack_size = compile_node(node->right);
+
+	// fold constant operands (errors are still reported when evaluating)
+	bool left_const = right_begin - left_begin == 1 && program[left_begin].code == FOC_const;
+	bool right_const = program.size() - right_begin == 1 && program[right_begin].code == FOC_const;
+	if (left_const && right_const && exe != exe_error) {
+	    double value = exe(program[left_begin].value, program[right_begin].value);
+	    program.resize(left_begin);
+	    return push_const(value);
+	}
+
+	Function_Instruction instruction{FOC_call, {}};
+	instruction.exe = exe;
+	if      (exe == exe_add)       instruction.code = FOC_add;
+	else if (exe == exe_sub)       instruction.code = FOC_sub;
+	else if (exe == exe_mul)       instruction.code = FOC_mul;
+	else if (exe == exe_div)       instruction.code = FOC_div;
+	else if (exe == exe_sub_unary && !node->left) instruction.code = FOC_neg;
+
+	if (instruction.code == FOC_neg)
+	    program.erase(program.begin() + left_begin); // the missing left operand
+	program.push_back(instruction);
+	return instruction.code == FOC_neg ? right_stack_size : std::max(left_stack_size, right_stack_size + 1);
+    }
+
+    Function_Instruction instruction{FOC_const, {}};
+    switch(node->tkn.type) {
+    case tkn_int:
+    case tkn_real:
+	return push_const(node->const_value);
+    case tkn_ident:
+	instruction.code = FOC_param;
+	instruction.param_idx = node->param_idx;
+	program.push_back(instruction);
+	return 1;
+    case tkn_x:
+	instruction.code = FOC_x;
+	program.push_back(instruction);
+	return 1;
+    case tkn_true:
+	return push_const(1);
+    case tkn_false:
+	return push_const(0);
+    case tkn_pi:
+	return push_const(UTILS_PI);
+    case tkn_euler:
+	return push_const(UTILS_EULER);
+    default:
+	return push_const(std::numeric_limits<double>().quiet_NaN());
+    }
+}
+
+/* Symbolic Differentiation **************************/
+
+static Op_Tree_Node* new_node(Token_enum type, Op_Tree_Node* left, Op_Tree_Node* right)
+{
+    Token tkn;
+    tkn.type = type;
+    Op_Tree_Node* node = new Op_Tree_Node{tkn};
+    node->left = left;
+    node->right = right;
+    return node;
+}
+
+static Op_Tree_Node* new_const_node(double value)
+{
+    Op_Tree_Node* node = new_node(tkn_real, nullptr, nullptr);
+    node->tkn.d = value;
+    node->const_value = value;
+    return node;
+}
+
+static Op_Tree_Node* copy_node(const Op_Tree_Node* node)
+{
+    if (!node)
+	return nullptr;
+    Op_Tree_Node* copy = new_node(node->tkn.type, copy_node(node->left), copy_node(node->right));
+    copy->tkn = node->tkn;
+    copy->param_idx = node->param_idx;
+    copy->const_value = node->const_value;
+    return copy;
+}
+
+// A derivative of nullptr is zero, which is left out of sums and products.
+
+static Op_Tree_Node* add_derivatives(Op_Tree_Node* a, Op_Tree_Node* b)
+{
+    if (!a) return b;
+    if (!b) return a;
+    return new_node(Token_enum('+'), a, b);
+}
+
+static Op_Tree_Node* sub_derivatives(Op_Tree_Node* a, Op_Tree_Node* b)
+{
+    if (!b) return a;
+    if (!a) return new_node(Token_enum('-'), nullptr, b);
+    return new_node(Token_enum('-'), a, b);
+}
+
+// derivative * factor
+static Op_Tree_Node* mul_derivative(Op_Tree_Node* derivative, Op_Tree_Node* factor)
+{
+    if (!derivative) {
+	delete factor;
+	return nullptr;
+    }
+    return new_node(Token_enum('*'), derivative, factor);
+}
+
+// the derivative of the unary function at its argument arg (without the inner derivative).
+static Op_Tree_Node* derive_unary_function(Token_enum type, const Op_Tree_Node* arg)
+{
+    auto one = []() { return new_const_node(1); };
+    auto square = [&]() { return new_node(tkn_pow, copy_node(arg), new_const_node(2)); };
+    auto square_root = [&](Op_Tree_Node* node) { return new_node(tkn_pow, node, new_const_node(0.5)); };
+
+    switch (type) {
+    case tkn_sin:   return new_node(tkn_cos, nullptr, copy_node(arg));
+    case tkn_cos:   return new_node(Token_enum('-'), nullptr, new_node(tkn_sin, nullptr, copy_node(arg)));
+    case tkn_tan:   return new_node(Token_enum('/'), one(), new_node(tkn_pow, new_node(tkn_cos, nullptr, copy_node(arg)), new_const_node(2)));
+    case tkn_asin:  return new_node(Token_enum('/'), one(), square_root(new_node(Token_enum('-'), one(), square())));
+    case tkn_acos:  return new_node(Token_enum('/'), new_const_node(-1), square_root(new_node(Token_enum('-'), one(), square())));
+    case tkn_atan:  return new_node(Token_enum('/'), one(), new_node(Token_enum('+'), one(), square()));
+    case tkn_sinh:  return new_node(tkn_cosh, nullptr, copy_node(arg));
+    case tkn_cosh:  return new_node(tkn_sinh, nullptr, copy_node(arg));
+    case tkn_tanh:  return new_node(Token_enum('/'), one(), new_node(tkn_pow, new_node(tkn_cosh, nullptr, copy_node(arg)), new_const_node(2)));
+    case tkn_asinh: return new_node(Token_enum('/'), one(), square_root(new_node(Token_enum('+'), square(), one())));
+    case tkn_acosh: return new_node(Token_enum('/'), one(), square_root(new_node(Token_enum('-'), square(), one())));
+    case tkn_atanh: return new_node(Token_enum('/'), one(), new_node(Token_enum('-'), one(), square()));
+    case tkn_ln:    return new_node(Token_enum('/'), one(), copy_node(arg));
+    default:        return nullptr;
+    }
+}
+
+// d node / d parameter, nullptr if it is zero. supported is cleared, if an operation has no derivative.
+static Op_Tree_Node* derive_node(const Op_Tree_Node* node, size_t param_idx, bool& supported)
+{
+    if (!node || !supported)
+	return nullptr;
+
+    if (!node->left && !node->right) {
+	if (node->tkn.type == tkn_ident && node->param_idx == param_idx)
+	    return new_const_node(1);
+	return nullptr;
+    }
+
+    const Op_Tree_Node* left = node->left;
+    const Op_Tree_Node* right = node->right;
+    
+    switch (uint32_t(node->tkn.type)) {
+    case tkn_or:
+    case tkn_and:
+    case tkn_eq:
+    case tkn_neq:
+    case '<':
+    case '>':
+    case tkn_less_eq:
+    case tkn_greater_eq:
+    case '!':
+	return nullptr; // piecewise constant
+    default:
+	break;
+    }
+
+    Op_Tree_Node* d_left = derive_node(left, param_idx, supported);
+    Op_Tree_Node* d_right = derive_node(right, param_idx, supported);
+    if (!d_left && !d_right)
+	return nullptr; // independent of the parameter
+
+    if (left && right) {
+	switch (uint32_t(node->tkn.type)) {
+	case '+':
+	    return add_derivatives(d_left, d_right);
+	case '-':
+	    return sub_derivatives(d_left, d_right);
+	case '*':
+	    return add_derivatives(mul_derivative(d_left, copy_node(right)), mul_derivative(d_right, copy_node(left)));
+	case '/':
+	    // (l' - l / r * r') / r
+	    return mul_derivative(sub_derivatives(d_left, mul_derivative(d_right, new_node(Token_enum('/'), copy_node(left), copy_node(right)))),
+				  new_node(Token_enum('/'), new_const_node(1), copy_node(right)));
+	case tkn_pow:
+	    if (!d_right) {
+		// r * l ** (r - 1) * l'
+		return mul_derivative(d_left, new_node(Token_enum('*'), copy_node(right),
+						       new_node(tkn_pow, copy_node(left), new_node(Token_enum('-'), copy_node(right), new_const_node(1)))));
+	    }
+	    // l ** r * (r' * ln(l) + r * l' / l)
+	    return mul_derivative(add_derivatives(mul_derivative(d_right, new_node(tkn_ln, nullptr, copy_node(left))),
+						  mul_derivative(d_left, new_node(Token_enum('/'), copy_node(right), copy_node(left)))),
+				  copy_node(node));
+	default:
+	    break;
+	}
+    }
+    else if (right) {
+	switch (uint32_t(node->tkn.type)) {
+	case '+':
+	    return d_right;
+	case '-':
+	    return sub_derivatives(nullptr, d_right);
+	default:
+	    if (Op_Tree_Node* derivative = derive_unary_function(node->tkn.type, right))
+		return mul_derivative(d_right, derivative);
+	    break;
+	}
+    }
+
+    delete d_left;
+    delete d_right;
+    supported = false;
+    return nullptr;
+}
+
+Function_Op_Tree Function_Op_Tree::get_param_derivative(size_t param_idx) const
+{
+    Function_Op_Tree derivative;
+    if (base_node) {
+	bool supported = true;
+	derivative.base_node = derive_node(base_node, param_idx, supported);
+	if (!supported) {
+	    delete derivative.base_node;
+	    derivative.base_node = nullptr;
+	    return derivative;
+	}
+	if (!derivative.base_node)
+	    derivative.base_node = new_const_node(0);
+	derivative.compile();
+    }
+    return derivative;
+}
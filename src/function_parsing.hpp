@@ -2,6 +2,8 @@
 
 #include <array>
 #include <cstddef>
+#include <cstdint>
+#include <vector>
 
 #include "lexer.hpp"
 
@@ -26,16 +28,60 @@ struct Op_Tree_Node
     double const_value;
 };
 
+// The op tree compiled into a flat program in postfix order, which is run on a small stack without recursion.
+// Parameters are read when running, so changing them needs no recompilation. Constant sub trees are folded.
+enum Function_Op_Code : uint8_t
+{
+    FOC_const,
+    FOC_param,
+    FOC_x,
+    FOC_add,
+    FOC_sub,
+    FOC_mul,
+    FOC_div,
+    FOC_neg,
+    FOC_call, // any other operation, called with the two topmost values
+};
+
+struct Function_Instruction
+{
+    Function_Op_Code code;
+    union {
+	double value;
+	size_t param_idx;
+	double (*exe)(double left, double right);
+    };
+};
+
+// Deeper trees are evaluated by walking the tree.
+constexpr int FUNCTION_PROGRAM_MAX_STACK_SIZE = 64;
+constexpr size_t FUNCTION_BLOCK_SIZE = 256;
+
 struct Function_Op_Tree
 {
     Op_Tree_Node *base_node = nullptr;
 
+    // must be called after changing the tree.
+    void compile();
+    
     double evaluate(const Generic_Function& generic_function, double x) const;
+    // evaluates the program for blocks of FUNCTION_BLOCK_SIZE values at once, every stack entry is a column of values.
+    void evaluate_many(const Generic_Function& generic_function, const double* x, double* y, size_t n) const;
+    double evaluate_tree(const Generic_Function& generic_function, double x) const; // without the compiled program
     std::string get_string_no_value(const Generic_Function& generic_function) const;
     std::string get_string_value(const Generic_Function& generic_function) const;
+    bool is_compiled() const { return !program.empty(); }
+
+    // The compiled partial derivative with respect to the parameter. Its base_node is nullptr, if an operation of the tree
+    // has no derivative.
+    Function_Op_Tree get_param_derivative(size_t param_idx) const;
 
 private:
+
+    std::vector<Function_Instruction> program;
+    int program_stack_size = 0;
     
+    int compile_node(Op_Tree_Node* node);
     double evaluate_node(const Generic_Function& generic_function, double x, Op_Tree_Node* node) const;
     void stringify_op_tree(const Generic_Function& generic_function, std::string &str,
 			   Op_Tree_Node* node, bool show_values) const;
@@ -98,6 +144,7 @@ inline double exe_tanh(EXE_ARGS)       { return std::tanh(right); }
 inline double exe_asinh(EXE_ARGS)      { return std::asinh(right); }
 inline double exe_acosh(EXE_ARGS)      { return std::acosh(right); }
 inline double exe_atanh(EXE_ARGS)      { return std::atanh(right); }
+inline double exe_ln(EXE_ARGS)         { return std::log(right); }
 
 struct Semantic_code {
     int lbp = 0; // left-binding-power
@@ -159,6 +206,7 @@ consteval std::array<Semantic_code, tkn_SIZE> get_tkn_semantics_table()
     table[tkn_asinh]       = {0, 15,  led_error,  nud_right, exe_error, exe_asinh};
     table[tkn_acosh]       = {0, 15,  led_error,  nud_right, exe_error, exe_acosh};
     table[tkn_atanh]       = {0, 15,  led_error,  nud_right, exe_error, exe_atanh};
+    table[tkn_ln]          = {0, 15,  led_error,  nud_right, exe_error, exe_ln};
 
     
     /* grouping */
@@ -1,20 +1,18 @@
 #include "functions.hpp"
 
 #include "data_manager.hpp"
-#include "app_loop.hpp"
 #include "function_parsing.hpp"
 #include "global_vars.hpp"
 #include "raylib.h"
 #include "utils.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
 #include <string>
 #include <random>
 #include <iostream>
 
-static void function_fit_iterative_naive(Plot_Data *data, Function &function, std::vector<double *> &param_list, int iterations);
-static double squared_error(Plot_Data *data, Function &function);
-static double squared_error_derivative(Plot_Data* data, double *param, Function& function);
 
 void Function::get_all_param_ref(std::vector<double*>& param_list)
 {
@@ -29,6 +27,29 @@ void Function::get_all_param_ref(std::vector<double*>& param_list)
     }
 }
 
+int Function::get_parameter_ref_idx(const double* param_ref)
+{
+    for (int idx = 0; double* ref = get_parameter_ref(idx); ++idx) {
+	if (ref == param_ref)
+	    return idx;
+    }
+    return -1;
+}
+
+Parameter_Bounds Function::get_parameter_bounds(int idx) const
+{
+    if (idx >= 0 && size_t(idx) < param_bounds.size())
+	return param_bounds[idx];
+    return {};
+}
+
+void Function::set_parameter_bounds(int idx, Parameter_Bounds bounds)
+{
+    if (size_t(idx) >= param_bounds.size())
+	param_bounds.resize(idx + 1);
+    param_bounds[idx] = bounds;
+}
+
 void Function::update_content_tree_element(size_t index)
 {
     content_element.name = "function " + std::to_string(index) + (!info.header.empty() ? " '" + info.header + "'" : "");
@@ -45,11 +66,81 @@ void Function::update_content_tree_element(size_t index)
 	content_element.content.push_back({"fit of "});
 	content_element.content.push_back({fit_from_data->content_element.name, false, fit_from_data->info.color});
     }
+
+    char buffer[128];
+    for (int idx = 0; get_parameter_ref(idx); ++idx) {
+	Parameter_Bounds bounds = get_parameter_bounds(idx);
+	if (bounds.lower != -HUGE_VAL || bounds.upper != HUGE_VAL) {
+	    snprintf(buffer, sizeof(buffer), "%s in [%g, %g]", get_parameter_name(idx).c_str(), bounds.lower, bounds.upper);
+	    content_element.content.push_back({buffer});
+	}
+    }
+    
+    if (fit_result.running) {
+	snprintf(buffer, sizeof(buffer), "fitting, iteration %d of %d, rms error = %g", fit_result.iterations, fit_result.max_iterations,
+		 fit_result.rms_error);
+	content_element.content.push_back({buffer});
+    }
+    else if (fit_result.valid) {
+	snprintf(buffer, sizeof(buffer), "%s after %d iterations, rms error = %g", fit_result.converged ? "converged" : "not converged",
+		 fit_result.iterations, fit_result.rms_error);
+	content_element.content.push_back({buffer});
+    }
+    if (fit_result.running || fit_result.valid) {
+	for (size_t i = 0; i < fit_result.param_indices.size(); ++i) {
+	    int idx = fit_result.param_indices[i];
+	    double* param_ref = get_parameter_ref(idx);
+	    if (!param_ref)
+		continue;
+	    if (fit_result.running)
+		snprintf(buffer, sizeof(buffer), "%s = %g", get_parameter_name(idx).c_str(), *param_ref);
+	    else
+		snprintf(buffer, sizeof(buffer), "%s = %g +- %.3g", get_parameter_name(idx).c_str(), *param_ref, fit_result.get_uncertainty(i));
+	    content_element.content.push_back({buffer});
+	}
+    }
+}
+
+void Function::evaluate_many(const double* x, double* y, size_t n) const
+{
+    for (size_t i = 0; i < n; ++i)
+	y[i] = (*this)(x[i]);
 }
 
 /* Sinusoidal Function **************************/
 
 double Sinusoidal_Function::operator()(double x) const { return a + b * std::sin(c * x + d); }
+
+// plain loops without calls or branches, so the compiler can vectorize them.
+void Sinusoidal_Function::evaluate_many(const double* x, double* y, size_t n) const
+{
+    for (size_t i = 0; i < n; ++i)
+	y[i] = a + b * std::sin(c * x[i] + d);
+}
+
+bool Sinusoidal_Function::evaluate_derivative_many(const double* param, const double* x, double* dy, size_t n) const
+{
+    if (param == &a) {
+	std::fill(dy, dy + n, 1.0);
+    }
+    else if (param == &b) {
+	for (size_t i = 0; i < n; ++i)
+	    dy[i] = std::sin(c * x[i] + d);
+    }
+    else if (param == &c) {
+	for (size_t i = 0; i < n; ++i)
+	    dy[i] = b * std::cos(c * x[i] + d) * x[i];
+    }
+    else if (param == &d) {
+	for (size_t i = 0; i < n; ++i)
+	    dy[i] = b * std::cos(c * x[i] + d);
+    }
+    else {
+	return false;
+    }
+    return true;
+}
+
 std::string Sinusoidal_Function::get_string_value() const { return std::to_string(a) + " + " + std::to_string(b) + " * sin(" + std::to_string(c) + " * x + " + std::to_string(d) + ")"; }
 std::string Sinusoidal_Function::get_string_no_value() const { return "a + b * sin(c * x + d)"; }
 
@@ -80,7 +171,7 @@ void Sinusoidal_Function::fit_to_data(Plot_Data *plot_data, int iterations, std:
     if (warm_start) {
 	sinusoid_fit_approximation(plot_data);
     }
-    function_fit_iterative_naive(plot_data, *this, param_list, iterations);
+    data_manager.start_fit(this, plot_data, param_list, iterations);
 }
 
 double* Sinusoidal_Function::get_parameter_ref(int idx)
@@ -94,6 +185,11 @@ double* Sinusoidal_Function::get_parameter_ref(int idx)
     }    
 }
 
+std::string Sinusoidal_Function::get_parameter_name(int idx) const
+{
+    return idx >= 0 && idx < 4 ? std::string(1, char('a' + idx)) : "";
+}
+
 // Sinusoidal Fit Algorithm (for first approximation):
 // https://stackoverflow.com/questions/77350332/sine-curve-to-fit-data-cloud-using-c
 
@@ -399,6 +495,24 @@ void Sinusoidal_Function::sinusoid_fit_approximation(Plot_Data* data)
 /* Linear Function **************************/
 
 double Linear_Function::operator()(double x) const { return a * x + b; }
+
+void Linear_Function::evaluate_many(const double* x, double* y, size_t n) const
+{
+    for (size_t i = 0; i < n; ++i)
+	y[i] = a * x[i] + b;
+}
+
+bool Linear_Function::evaluate_derivative_many(const double* param, const double* x, double* dy, size_t n) const
+{
+    if (param == &a)
+	std::copy(x, x + n, dy);
+    else if (param == &b)
+	std::fill(dy, dy + n, 1.0);
+    else
+	return false;
+    return true;
+}
+
 std::string Linear_Function::get_string_value() const { return std::to_string(a) + " * x + " + std::to_string(b); }
 std::string Linear_Function::get_string_no_value() const { return "a * x + b"; }
 
@@ -425,7 +539,7 @@ void Linear_Function::fit_to_data(Plot_Data *plot_data, int iterations, std::vec
     if (warm_start) {
 	linear_fit_approximation(plot_data);
     }
-    function_fit_iterative_naive(plot_data, *this, param_list, iterations);
+    data_manager.start_fit(this, plot_data, param_list, iterations);
 }
 
 double* Linear_Function::get_parameter_ref(int idx)
@@ -437,6 +551,11 @@ double* Linear_Function::get_parameter_ref(int idx)
     }
 }
 
+std::string Linear_Function::get_parameter_name(int idx) const
+{
+    return idx >= 0 && idx < 2 ? std::string(1, char('a' + idx)) : "";
+}
+
 void Linear_Function::linear_fit_approximation(Plot_Data *data)
 {
     double Ax, Ay, Bx, By;
@@ -476,6 +595,23 @@ Generic_Function::Generic_Function(Lexer& lexer)
 	op_tree.base_node = nullptr;
 	params.clear();
     }
+    op_tree.compile();
+
+    for (size_t i = 0; i < params.size(); ++i)
+	param_derivatives.push_back(op_tree.get_param_derivative(i));
+}
+
+bool Generic_Function::evaluate_derivative_many(const double* param, const double* x, double* dy, size_t n) const
+{
+    for (size_t i = 0; i < params.size() && i < param_derivatives.size(); ++i) {
+	if (param == &params[i].val) {
+	    if (!param_derivatives[i].base_node)
+		return false;
+	    param_derivatives[i].evaluate_many(*this, x, dy, n);
+	    return true;
+	}
+    }
+    return false;
 }
 
 double* Generic_Function::get_parameter_ref(std::string_view name)
@@ -503,7 +639,7 @@ void Generic_Function::fit_to_data(Plot_Data *plot_data, int iterations, std::ve
     // if (warm_start) {
     // generic_fit_approximation(plot_data, iterations);
     // }
-    function_fit_iterative_naive(plot_data, *this, param_list, iterations);
+    data_manager.start_fit(this, plot_data, param_list, iterations);
 }
 
 double* Generic_Function::get_parameter_ref(int idx)
@@ -547,20 +683,14 @@ void Generic_Function::generic_fit_approximation(Plot_Data *data, int iterations
 
     for (size_t param_i = 0; param_i < params.size(); ++param_i) {
 	for (int surv_i = 0; surv_i < surviver_cnt; ++surv_i) {
-	    best_params[param_i][surv_i].err = squared_error(data, *this);
+	    best_params[param_i][surv_i].err = get_squared_error(data, *this);
 	}
     }
 
-    double time_begin = GetTime();
-    
     for (int itr = 0; itr < iterations; ++itr)
     {
 	for (int g_i = 0; g_i < generation_size / surviver_cnt; ++g_i)
 	{
-	    // if (GetTime() - time_begin > 1.0 / (double(TARGET_FPS) * 0.33)) {
-		app_loop();
-		time_begin = GetTime();
-	    // } 
 	    for (int surv_i = 0; surv_i < surviver_cnt; ++surv_i) {
 		for (size_t param_i = 0; param_i < params.size(); ++param_i)
 		{
@@ -569,7 +699,7 @@ void Generic_Function::generic_fit_approximation(Plot_Data *data, int iterations
 		    std::normal_distribution<double> this_mutator{best_params[param_i][surv_i].val, std::abs(best_params[param_i][surv_i].val) * 10};
 		    
 		    params[param_i].val = this_mutator(rand_gen);
-		    double this_error = squared_error(data, *this);
+		    double this_error = get_squared_error(data, *this);
 
 		    // Based on the fact that j will be correct-index + 1 after the for loop ends.
 		    int i = -1;
@@ -588,101 +718,3 @@ void Generic_Function::generic_fit_approximation(Plot_Data *data, int iterations
 	params[i].val = best_params[i].back().val;
     }
 }
-
-/* Function Type Independents **************************/
-
-static double squared_error(Plot_Data* data, Function& function)
-{
-    double squared_error = 0;
-    
-    if (data->x) {
-	for (size_t i = 0; i < data->size(); ++i) {
-	    squared_error += (function(data->x->y[i]) - data->y[i]) * (function(data->x->y[i]) - data->y[i]);
-	}
-    }
-    else {
-	for (size_t i = 0; i < data->size(); ++i) {
-	    squared_error += (function(i) - data->y[i]) * (function(i) - data->y[i]);
-	}
-    }
-    return squared_error / double(data->size());
-}
-
-static double squared_error_derivative(Plot_Data* data, double *param, Function& function)
-{
-    const double delta_x = (0.001 / (data->size()));
-    double squared_error_ya = squared_error(data, function);
-    double orig_param = *param;
-    *param += delta_x;
-    double squared_error_yb = squared_error(data, function);
-    *param = orig_param;
-    return (squared_error_yb - squared_error_ya) / delta_x;
-}
-
-static void function_fit_iterative_naive(Plot_Data *data, Function &function, std::vector<double*>& param_list, int iterations)
-{
-    // logger.log_info("Error before iterative optimization: %f\n", squared_error(data, function));
-    
-    std::vector<double> derivatives(param_list.size(), 0);
-    std::vector<double> step_sizes(param_list.size(), 0.00000001);
-
-    double time_begin = GetTime();
-    double time_begin_begin = time_begin;
-
-    for (int i = 0; i < iterations; ++i)
-    {
-	if (GetTime() - time_begin > 1.0 / (double(TARGET_FPS) * 0.33)) {
-	    app_loop();
-	    time_begin = GetTime();
-	}
-	
-	for (size_t i = 0; i < param_list.size(); ++i) {
-	    derivatives[i] = squared_error_derivative(data, param_list[i], function);
-	}
-
-	// searching for the best 
-	for (size_t i = 0; i < param_list.size(); ++i)
-	{
-	    double orig_param = *param_list[i];
-	    double best_error = squared_error(data, function);
-	    bool converged = true;
-	    
-	    double best_step_size = step_sizes[i];
-	    for (double step_size = best_step_size * 100; step_size >= best_step_size * 0.001 && step_size > 10e-15; step_size *= 0.1)
-	    {
-		*param_list[i] -= derivatives[i] * step_size;
-		
-		double this_error = squared_error(data, function);
-		if (best_error > this_error) {
-		    converged = false;
-		    best_error = this_error;
-		    best_step_size = step_size;
-		}
-		
-		*param_list[i] = orig_param;
-	    }
-
-	    if (!converged) {
-		*param_list[i] -= derivatives[i] * best_step_size;
-		step_sizes[i] = best_step_size;
-	    }
-	    else {
-		step_sizes[i] = best_step_size * 0.001;
-	    }
-	}
-
-	bool all_converged = true;
-	for (size_t i = 0; i < param_list.size(); ++i) {
-	    if (step_sizes[i] > 10e-14) {
-		all_converged = false;
-	    }
-	}
-	if (all_converged) {
-	    // logger.log_info("Converged at iteration: %d\n", i);
-	    break;
-	}
-	    
-    }
-    // logger.log_info("Error after iterative optimization: %f\n", squared_error(data, function));
-    // logger.log_info("Elapsed time: %f s\n", GetTime() - time_begin_begin);
-}
@@ -2,6 +2,7 @@
 
 #include <vector>
 
+#include "function_fit.hpp"
 #include "function_parsing.hpp"
 #include "gui_elements.hpp"
 
@@ -12,19 +13,32 @@ public:
     Content_Tree_Element content_element;
     Plot_Data* fit_from_data = nullptr;
     size_t index = 0;
+    std::vector<Parameter_Bounds> param_bounds; // by parameter index, missing ones are unbounded
+    Fit_Result fit_result;
 
     virtual ~Function() {};
+    virtual Function* clone() const = 0; // a copy of the same type
     
     void update_content_tree_element(size_t index);
     void get_all_param_ref(std::vector<double*>& param_list);
+    int get_parameter_ref_idx(const double* param_ref);
+    Parameter_Bounds get_parameter_bounds(int idx) const;
+    void set_parameter_bounds(int idx, Parameter_Bounds bounds);
     
     virtual double operator()(double x) const = 0;
+    // y[i] = f(x[i]) for n values, x and y may be the same array. Use this for anything with more than a few values.
+    virtual void evaluate_many(const double* x, double* y, size_t n) const;
+    // dy[i] = d f(x[i]) / d param for n values, param is a reference from get_parameter_ref.
+    // Returns false, if there is no analytic derivative.
+    virtual bool evaluate_derivative_many([[maybe_unused]] const double* param, [[maybe_unused]] const double* x, [[maybe_unused]] double* dy,
+					  [[maybe_unused]] size_t n) const { return false; }
     virtual std::string get_string_value() const = 0;
     virtual std::string get_string_no_value() const = 0;
     virtual double* get_parameter_ref(std::string_view name) = 0;
     virtual int get_parameter_idx(std::string_view name) = 0;
     virtual void fit_to_data(Plot_Data* plot_data, int iterations, std::vector<double*>& param_list, bool warm_start = true) = 0;
     virtual double* get_parameter_ref(int idx) = 0;
+    virtual std::string get_parameter_name(int idx) const = 0;
 };
 
 
@@ -33,17 +47,21 @@ class Sinusoidal_Function : public Function
 public:
 
     Sinusoidal_Function(){}
+    Function* clone() const override { return new Sinusoidal_Function(*this); }
     
     // y = a + b * sin(c * x + d)
     double a = 0, b = 1, c = 1, d = 0;
 
     double operator()(double x) const override;
+    void evaluate_many(const double* x, double* y, size_t n) const override;
+    bool evaluate_derivative_many(const double* param, const double* x, double* dy, size_t n) const override;
     std::string get_string_value() const override;
     std::string get_string_no_value() const override;
     double* get_parameter_ref(std::string_view name) override;
     int get_parameter_idx(std::string_view name) override;
     void fit_to_data(Plot_Data* plot_data, int iterations, std::vector<double*>& param_list, bool warm_start = true) override;
     double* get_parameter_ref(int idx) override;
+    std::string get_parameter_name(int idx) const override;
     
 private:
 
@@ -55,17 +73,21 @@ class Linear_Function : public Function
 public:
 
     Linear_Function(){}
+    Function* clone() const override { return new Linear_Function(*this); }
     
     // y = a * x + b
     double a = 1, b = 0;
 
     double operator()(double x) const override;
+    void evaluate_many(const double* x, double* y, size_t n) const override;
+    bool evaluate_derivative_many(const double* param, const double* x, double* dy, size_t n) const override;
     std::string get_string_value() const override;
     std::string get_string_no_value() const override;
     double *get_parameter_ref(std::string_view name) override;
     int get_parameter_idx(std::string_view name) override;
     void fit_to_data(Plot_Data *plot_data, int iterations, std::vector<double *> &param_list, bool warm_start = true) override;
     double *get_parameter_ref(int idx) override;
+    std::string get_parameter_name(int idx) const override;
 
   private:
 
@@ -84,17 +106,22 @@ public:
 
     Generic_Function(){}
     Generic_Function(Lexer& lexer);
+    Function* clone() const override { return new Generic_Function(*this); } // the op tree is shared, it is never changed after parsing
     
     std::vector<Parameter> params;
     Function_Op_Tree op_tree;
+    std::vector<Function_Op_Tree> param_derivatives; // by parameter index, built with the op tree
 
     double operator()(double x) const override { return op_tree.evaluate(*this, x); }
+    void evaluate_many(const double* x, double* y, size_t n) const override { op_tree.evaluate_many(*this, x, y, n); }
+    bool evaluate_derivative_many(const double* param, const double* x, double* dy, size_t n) const override;
     std::string get_string_value() const override { return op_tree.get_string_value(*this); }
     std::string get_string_no_value() const override { return op_tree.get_string_no_value(*this); }
     double* get_parameter_ref(std::string_view name) override;
     int get_parameter_idx(std::string_view name) override;
     void fit_to_data(Plot_Data* plot_data, int iterations, std::vector<double*>& param_list, bool warm_start = true) override;
     double* get_parameter_ref(int idx) override;
+    std::string get_parameter_name(int idx) const override { return idx >= 0 && size_t(idx) < params.size() ? params[idx].name : ""; }
 
 private:
 
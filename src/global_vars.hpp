@@ -3,6 +3,7 @@
 #include "raylib.h"
 #include "utils.hpp"
 #include <cstdint>
+#include <memory>
 
 constexpr int TARGET_FPS = 60;
 constexpr int SCREEN_WIDTH = 800;
@@ -14,10 +15,18 @@ inline Font g_app_font_22;
 
 inline int g_keyboard_lock = 0;
 
+// The size of the plot without a window, set by Faster_Plot::init_headless.
+inline Vec2<int> g_headless_screen_size = {0, 0};
+
+// Set by everything which changes what is drawn: camera movement, data mutations, commands and GUI input.
+// The app loop only draws a new frame, if it is set.
+inline bool g_frame_dirty = true;
+
 inline Logger logger;
 
 constexpr std::string DEFAULT_EXPORT_FILE_NAME = "export";
 constexpr std::string DEFAULT_SAVE_FILE_NAME = "save";
+constexpr std::string DEFAULT_RENDER_FILE_NAME = "plot";
 
 enum Command_Flags {
     CF_none         = 0,
@@ -25,10 +34,13 @@ enum Command_Flags {
     CF_only_on_save = 1 << 1,
 };
 
+class Lexer;
+
 struct Command
 {
     std::string cmd;
     Command_Flags flags;
+    std::shared_ptr<Lexer> lexer; // the tokens of cmd, so running it again does not tokenize it again (see re_run_commands).
 };
 
 struct All_Commands
@@ -38,7 +50,7 @@ struct All_Commands
 	if (command_idx + 1 < int64_t(all_commands.size())) {
 	    all_commands.erase(all_commands.begin() + command_idx + 1, all_commands.end());
 	}
-	all_commands.push_back({cmd, cmd_flags});
+	all_commands.push_back({cmd, cmd_flags, nullptr});
 	command_idx = all_commands.size() - 1;
     }
     
@@ -81,6 +93,7 @@ struct All_Commands
     }
     
     const std::vector<Command>& get_commands() const { return all_commands; }
+    Command& get_command(int64_t idx) { return all_commands[idx]; }
     bool has_commands() const { return !all_commands.empty(); }
     int64_t get_index() const { return command_idx; }
 
@@ -6,6 +6,7 @@
 #include "object_operations.hpp"
 #include "command_parser.hpp"
 #include "lexer.hpp"
+#include "plot_file.hpp"
 #include "utils.hpp"
 
 // content tree
@@ -31,10 +32,13 @@ bool handle_dropped_files()
 	for(uint32_t i = 0; i < path_list.count; ++i) {
 	    std::string file_extension = get_file_extension(path_list.paths[i]);
 	    if (file_extension == ".script") {
-		run_command_file_absolute_path(std::string(path_list.paths[i]));
+		data_manager.run_script_after_loading(std::string(path_list.paths[i]));
+	    }
+	    else if (file_extension == PLOT_FILE_EXTENSION && !data_manager.is_loading()) {
+		data_manager.load_external_plot_data(path_list.paths[i]); // nothing to parse, no need for the background loader
 	    }
 	    else {
-		data_manager.load_external_plot_data(path_list.paths[i]);
+		data_manager.load_external_plot_data_async(path_list.paths[i]);
 	    }
 	}
 	UnloadDroppedFiles(path_list);
@@ -121,6 +125,16 @@ void Text_Input::update()
 {
     if(!keyboard_access())
 	return;
+
+    if (input_active) {
+	static int previous_result = 0;
+	int result = size_t(GetTime() / TEXT_INPUT_CURSO_BLINK_TIME) % 2;
+	if (result != previous_result) {
+	    previous_result = result;
+	    show_cursor = !show_cursor;
+	    g_frame_dirty = true;
+	}
+    }
     
     std::string& input = lexer.get_input();
 
@@ -197,7 +211,7 @@ void Text_Input::update()
 	}
     }
     else if (!input.empty()) {
-	handle_command(lexer);
+	handle_typed_command(lexer);
 	prev_cmd_idx = g_all_commands.get_index();
 	lexer = Lexer{};
     }
@@ -209,13 +223,6 @@ void Text_Input::draw()
     if (input_active) {
 	char str[2] = {0, 0};
 
-	static int previous_result = 0;
-	int result = size_t(GetTime() / TEXT_INPUT_CURSO_BLINK_TIME) % 2;
-	if (result != previous_result) {
-	    previous_result = result;
-	    show_cursor = !show_cursor;
-	}
-
 	std::string& input = lexer.get_input();
 	
 	Vector2 size = {0, 0};
@@ -80,6 +80,7 @@ struct Text_Input
     Text_Input() : keyboard_lock_id(get_uuid()) {}
     void draw();
     void update();
+    bool is_active() const { return input_active; } // the cursor blinks, while the input is active
     
 private:
 
@@ -47,6 +47,17 @@ static const char *token_name_table[tkn_SIZE - 256]{
     "zero",
     "help",
     "iter",
+    "cancel",
+    "binary",
+    "float",
+    "bench",
+    "bound",
+    "fft",
+    "psd",
+    "conv",
+    "xcorr",
+    "capacity",
+    "render",
 
     "sin",
     "cos",
@@ -60,6 +71,7 @@ static const char *token_name_table[tkn_SIZE - 256]{
     "asinh",
     "acosh",
     "atanh",
+    "ln",
     "pi",
     "euler",
     
@@ -126,6 +138,17 @@ Token_enum keyword_compare(const std::string_view sv)
     case cte_hash_c_str("zero"): return tkn_zero;
     case cte_hash_c_str("help"): return tkn_help;
     case cte_hash_c_str("iter"): return tkn_iter;
+    case cte_hash_c_str("cancel"): return tkn_cancel;
+    case cte_hash_c_str("binary"): return tkn_binary;
+    case cte_hash_c_str("float"): return tkn_float;
+    case cte_hash_c_str("bench"): return tkn_bench;
+    case cte_hash_c_str("bound"): return tkn_bound;
+    case cte_hash_c_str("fft"): return tkn_fft;
+    case cte_hash_c_str("psd"): return tkn_psd;
+    case cte_hash_c_str("conv"): return tkn_conv;
+    case cte_hash_c_str("xcorr"): return tkn_xcorr;
+    case cte_hash_c_str("capacity"): return tkn_capacity;
+    case cte_hash_c_str("render"): return tkn_render;
 	
     case cte_hash_c_str("sin"): return tkn_sin;
     case cte_hash_c_str("cos"): return tkn_cos;
@@ -139,6 +162,7 @@ Token_enum keyword_compare(const std::string_view sv)
     case cte_hash_c_str("asinh"): return tkn_asinh;
     case cte_hash_c_str("acosh"): return tkn_acosh;
     case cte_hash_c_str("atanh"): return tkn_atanh;
+    case cte_hash_c_str("ln"): return tkn_ln;
     case cte_hash_c_str("pi"): return tkn_pi;
     case cte_hash_c_str("euler"): return tkn_euler;
     default: return tkn_ident;
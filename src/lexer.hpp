@@ -51,6 +51,17 @@ enum Token_enum : uint32_t {
     tkn_zero,
     tkn_help,
     tkn_iter,
+    tkn_cancel,
+    tkn_binary,
+    tkn_float,
+    tkn_bench,
+    tkn_bound,
+    tkn_fft, // data new = fft data 1
+    tkn_psd,
+    tkn_conv,
+    tkn_xcorr,
+    tkn_capacity, // data 0 capacity 1000
+    tkn_render, // render "plot.png" 1920 1080
 
     tkn_sin, // math keywords
     tkn_cos,
@@ -64,6 +75,7 @@ enum Token_enum : uint32_t {
     tkn_asinh,
     tkn_acosh,
     tkn_atanh,
+    tkn_ln,
     tkn_pi,
     tkn_euler,
 
@@ -0,0 +1,112 @@
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+bool Mapped_File::open(const std::string& file_name)
+{
+    close();
+
+    HANDLE file = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+	return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+	CloseHandle(file);
+	return false;
+    }
+
+    file_handle = file;
+    file_size = size_t(size.QuadPart);
+    opened = true;
+
+    // mapping an empty file fails
+    if (file_size == 0)
+	return true;
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+	close();
+	return false;
+    }
+    mapping_handle = mapping;
+
+    ptr = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!ptr) {
+	close();
+	return false;
+    }
+    return true;
+}
+
+void Mapped_File::close()
+{
+    if (ptr)
+	UnmapViewOfFile(ptr);
+    if (mapping_handle)
+	CloseHandle(mapping_handle);
+    if (file_handle)
+	CloseHandle(file_handle);
+
+    ptr = nullptr;
+    mapping_handle = nullptr;
+    file_handle = nullptr;
+    file_size = 0;
+    opened = false;
+}
+
+#else
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool Mapped_File::open(const std::string& file_name)
+{
+    close();
+
+    int fd = ::open(file_name.c_str(), O_RDONLY);
+    if (fd < 0)
+	return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+	::close(fd);
+	return false;
+    }
+
+    file_size = size_t(st.st_size);
+    opened = true;
+
+    if (file_size > 0) {
+	void* mapping = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (mapping == MAP_FAILED) {
+	    ::close(fd);
+	    close();
+	    return false;
+	}
+	madvise(mapping, file_size, MADV_SEQUENTIAL);
+	ptr = (const char*)mapping;
+    }
+
+    // the mapping stays valid after closing the descriptor
+    ::close(fd);
+    return true;
+}
+
+void Mapped_File::close()
+{
+    if (ptr)
+	munmap((void*)ptr, file_size);
+
+    ptr = nullptr;
+    file_size = 0;
+    opened = false;
+}
+
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read only memory mapping of a whole file.
+// The implementation lives in its own translation unit, since windows.h does not get along with raylib.h.
+struct Mapped_File
+{
+    Mapped_File() {}
+    Mapped_File(const Mapped_File&) = delete;
+    Mapped_File& operator=(const Mapped_File&) = delete;
+    ~Mapped_File() { close(); }
+
+    // returns false, if the file could not be mapped. An empty file is mapped successfully, with size 0.
+    bool open(const std::string& file_name);
+    void close();
+
+    const char* data() const { return ptr; }
+    size_t size() const { return file_size; }
+    bool is_open() const { return opened; }
+
+private:
+
+    const char* ptr = nullptr;
+    size_t file_size = 0;
+    bool opened = false;
+    void* file_handle = nullptr;    // windows only
+    void* mapping_handle = nullptr; // windows only
+};
@@ -1,9 +1,14 @@
 #include "object_operations.hpp"
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <filesystem>
+#include <vector>
 
+#include "data_filters.hpp"
 #include "data_manager.hpp"
+#include "thread_pool.hpp"
 #include "utils.hpp"
 #include "command_parser.hpp"
 #include "global_vars.hpp"
@@ -51,28 +56,35 @@ bool interp_plot_data(Plot_Data *plot_data, int n_itr)
     new_x[new_x.size() - 1] = plot_data->x->y[plot_data->x->y.size() - 1];
     new_y[new_y.size() - 1] = plot_data->y[plot_data->y.size() - 1];
 
-    plot_data->x->y = new_x;
-    plot_data->y = new_y;
+    plot_data->x->y = std::move(new_x);
+    plot_data->y = std::move(new_y);
+    plot_data->x->modified();
+    plot_data->modified();
 
     if (n_itr >= 2)
 	return interp_plot_data(plot_data, n_itr - 1);
     return true;
 }
 
-bool smooth_plot_data(Plot_Data *plot_data, int window_size)
+// every data is filtered by another task of the thread pool, into a new buffer.
+bool smooth_plot_data(const std::vector<Plot_Data*>& plot_data, const Filter& filter)
 {
-    if (plot_data->y.empty())
-	return false;
+    std::vector<std::vector<double>> filtered(plot_data.size());
+    thread_pool.run(plot_data.size(), [&](size_t i) {
+	filtered[i].resize(plot_data[i]->size());
+	apply_filter(filter, plot_data[i]->y.data(), plot_data[i]->size(), filtered[i].data());
+    });
 
-    for(size_t ix = 0; ix < plot_data->size(); ++ix)
-    {
-	double sum = 0;
-	for (int iw = - window_size; iw <= window_size; ++iw) {
-	    sum += plot_data->y[std::clamp(int(ix) + iw, 0, int(plot_data->size() - 1))];
+    bool success = true;
+    for (size_t i = 0; i < plot_data.size(); ++i) {
+	if (plot_data[i]->y.empty()) {
+	    success = false;
+	    continue;
 	}
-	plot_data->y[ix] = sum / double(2 * window_size + 1);
+	plot_data[i]->y = std::move(filtered[i]);
+	plot_data[i]->modified();
     }
-    return true;
+    return success;
 }
 
 // void fit_sinusoid_plot_data(Plot_Data *plot_data, Function *function)
@@ -86,7 +98,9 @@ bool get_extrema_plot_data(Plot_Data *object_plot_data, Plot_Data *plot_data)
     if (plot_data->y.empty())
 	return false;
     
-    object_plot_data->y.clear();
+    std::vector<double>& extrema_y = object_plot_data->y.edit();
+    std::vector<double>& extrema_x = object_plot_data->x->y.edit();
+    extrema_y.clear();
 
     double prev_val = plot_data->y[0];
     double val = plot_data->y[1];
@@ -97,14 +111,146 @@ bool get_extrema_plot_data(Plot_Data *object_plot_data, Plot_Data *plot_data)
 	val = plot_data->y[ix];
 	prev_val = plot_data->y[ix - 1];
 	if ((going_up && val < prev_val) || (!going_up && val > prev_val)) {
-	    object_plot_data->y.push_back(plot_data->y[ix - 1]);
-	    object_plot_data->x->y.push_back(plot_data->x ? plot_data->x->y[ix - 1] : ix - 1);
+	    extrema_y.push_back(plot_data->y[ix - 1]);
+	    extrema_x.push_back(plot_data->x ? plot_data->x->y[ix - 1] : ix - 1);
 	}
 	going_up = val >= prev_val;
     }
+    object_plot_data->modified();
+    object_plot_data->x->modified();
+    return true;
+}
+
+// the distance of two values in X, 1 for the index as X.
+static double get_sample_interval(Plot_Data *plot_data)
+{
+    size_t size = plot_data->size();
+    if (!plot_data->x || size < 2)
+	return 1;
+    double interval = (plot_data->x->y[size - 1] - plot_data->x->y[0]) / double(size - 1);
+    return interval != 0 && std::isfinite(interval) ? interval : 1;
+}
+
+static double get_first_x(Plot_Data *plot_data)
+{
+    return plot_data->x ? plot_data->x->y[0] : 0;
+}
+
+// the results replace the Y of object_plot_data, it gets a new X with x_begin + k * x_step.
+// object_plot_data can be one of the arguments, so this is called after the results are computed.
+static void set_spectrum_plot_data(Plot_Data *object_plot_data, std::vector<double>&& y, double x_begin, double x_step)
+{
+    std::vector<double> x(y.size());
+    for (size_t k = 0; k < x.size(); ++k)
+	x[k] = x_begin + double(k) * x_step;
+    object_plot_data->x = data_manager.new_plot_data();
+    object_plot_data->y = std::move(y);
+    object_plot_data->x->y = std::move(x);
+    object_plot_data->modified();
+    object_plot_data->x->modified();
+}
+
+bool fft_plot_data(Plot_Data *object_plot_data, Plot_Data *plot_data, bool phase)
+{
+    size_t size = plot_data->size();
+    if (size < 2)
+	return false;
+
+    double interval = get_sample_interval(plot_data);
+    std::vector<double> spectrum = phase ? phase_spectrum(plot_data->y.data(), size) : amplitude_spectrum(plot_data->y.data(), size);
+    set_spectrum_plot_data(object_plot_data, std::move(spectrum), 0, 1 / (double(size) * interval));
+    return true;
+}
+
+bool psd_plot_data(Plot_Data *object_plot_data, Plot_Data *plot_data, Window_Type window)
+{
+    size_t size = plot_data->size();
+    if (size < 2)
+	return false;
+
+    double interval = get_sample_interval(plot_data);
+    std::vector<double> density = power_spectral_density(plot_data->y.data(), size, 1 / interval, window);
+    set_spectrum_plot_data(object_plot_data, std::move(density), 0, 1 / (double(size) * interval));
+    return true;
+}
+
+// The values of the convolution are the sums over the products, they are not scaled by the sample interval.
+bool convolve_plot_data(Plot_Data *object_plot_data, Plot_Data *plot_data_a, Plot_Data *plot_data_b)
+{
+    if (plot_data_a->size() == 0 || plot_data_b->size() == 0)
+	return false;
+
+    double interval = get_sample_interval(plot_data_a->x ? plot_data_a : plot_data_b);
+    std::vector<double> result = convolve(plot_data_a->y.data(), plot_data_a->size(), plot_data_b->y.data(), plot_data_b->size());
+    set_spectrum_plot_data(object_plot_data, std::move(result), get_first_x(plot_data_a) + get_first_x(plot_data_b), interval);
     return true;
 }
 
+// X is the lag of b against a.
+bool cross_correlate_plot_data(Plot_Data *object_plot_data, Plot_Data *plot_data_a, Plot_Data *plot_data_b)
+{
+    if (plot_data_a->size() == 0 || plot_data_b->size() == 0)
+	return false;
+
+    double interval = get_sample_interval(plot_data_a->x ? plot_data_a : plot_data_b);
+    std::vector<double> result = cross_correlate(plot_data_a->y.data(), plot_data_a->size(), plot_data_b->y.data(), plot_data_b->size());
+    set_spectrum_plot_data(object_plot_data, std::move(result), -double(plot_data_b->size() - 1) * interval, interval);
+    return true;
+}
+
+static volatile double benchmark_sink; // keeps the evaluations from being optimized away
+
+// evaluates the function in batches for about BENCHMARK_SECONDS, returns the evaluations per second.
+template <typename Evaluate_Batch>
+static double measure_evaluations_per_second(Evaluate_Batch evaluate_batch)
+{
+    constexpr double BENCHMARK_SECONDS = 0.25;
+    constexpr size_t BENCHMARK_BATCH_SIZE = 1 << 16;
+
+    std::vector<double> x(BENCHMARK_BATCH_SIZE);
+    std::vector<double> y(BENCHMARK_BATCH_SIZE);
+    for (size_t i = 0; i < BENCHMARK_BATCH_SIZE; ++i)
+	x[i] = double(i) / double(BENCHMARK_BATCH_SIZE);
+    
+    double sum = 0;
+    size_t evaluation_cnt = 0;
+    double seconds = 0;
+    auto time_begin = std::chrono::steady_clock::now();
+    while (seconds < BENCHMARK_SECONDS) {
+	evaluate_batch(x.data(), y.data(), BENCHMARK_BATCH_SIZE);
+	for (size_t i = 0; i < BENCHMARK_BATCH_SIZE; ++i)
+	    sum += y[i];
+	evaluation_cnt += BENCHMARK_BATCH_SIZE;
+	seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - time_begin).count();
+    }
+    benchmark_sink = sum;
+    return double(evaluation_cnt) / seconds;
+}
+
+void benchmark_function(Function *function)
+{
+    double evaluations_per_second = measure_evaluations_per_second([&](const double* x, double* y, size_t n) {
+	for (size_t i = 0; i < n; ++i)
+	    y[i] = (*function)(x[i]);
+    });
+    double batch_evaluations_per_second = measure_evaluations_per_second([&](const double* x, double* y, size_t n) {
+	function->evaluate_many(x, y, n);
+    });
+    logger.log_info("function %zu: %.2f M evaluations/s, %.2f M evaluations/s in batches", function->index,
+		    evaluations_per_second / 1e6, batch_evaluations_per_second / 1e6);
+
+    Generic_Function* generic_function = dynamic_cast<Generic_Function*>(function);
+    if (generic_function && generic_function->op_tree.is_compiled()) {
+	double tree_evaluations_per_second = measure_evaluations_per_second([&](const double* x, double* y, size_t n) {
+	    for (size_t i = 0; i < n; ++i)
+		y[i] = generic_function->op_tree.evaluate_tree(*generic_function, x[i]);
+	});
+	logger.log_info(", compiled, %.2f M evaluations/s walking the op tree (%.1fx)", tree_evaluations_per_second / 1e6,
+			evaluations_per_second / tree_evaluations_per_second);
+    }
+    logger.log_info("\n");
+}
+
 void run_command_file(std::string file_name)
 {
     if (!(std::filesystem::exists(SCRIPT_DIRECTORY))) {
@@ -129,6 +275,9 @@ void run_command_file(std::string file_name)
 void run_command_file_absolute_path(std::string file_name)
 {
     auto content = parse_file_cstr(file_name.c_str());
+    if (content.second == 0) {
+	return;
+    }
     std::string file = content.first;
 
     logger.log_info("Running script '%s'\n", file_name.c_str());
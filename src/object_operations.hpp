@@ -1,10 +1,13 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include "utils.hpp"
+#include "fft.hpp"
 
 struct Plot_Data;
 struct Function;
+struct Filter;
 
 inline double add_op(double a, double b) { return a + b; }
 inline double sub_op(double a, double b) { return a - b; }
@@ -12,12 +15,22 @@ inline double mul_op(double a, double b) { return a * b; }
 inline double div_op(double a, double b) { return a / b; }
 
 bool interp_plot_data(Plot_Data *plot_data, int n_itr);
-bool smooth_plot_data(Plot_Data *plot_data, int window_size);
+bool smooth_plot_data(const std::vector<Plot_Data*>& plot_data, const Filter& filter);
 
 // void fit_sinusoid_plot_data(Plot_Data *plot_data, Function *function);
 
 bool get_extrema_plot_data(Plot_Data *object_plot_data, Plot_Data *plot_data);
 
+// The spectra, convolution and correlation of data, in object_plot_data with a new X. The sample interval is taken
+// from the first and last X of the data, the values are assumed to be equally spaced.
+bool fft_plot_data(Plot_Data *object_plot_data, Plot_Data *plot_data, bool phase);
+bool psd_plot_data(Plot_Data *object_plot_data, Plot_Data *plot_data, Window_Type window);
+bool convolve_plot_data(Plot_Data *object_plot_data, Plot_Data *plot_data_a, Plot_Data *plot_data_b);
+bool cross_correlate_plot_data(Plot_Data *object_plot_data, Plot_Data *plot_data_a, Plot_Data *plot_data_b);
+
+// logs the evaluations per second of the function, for generic functions also of walking the op tree.
+void benchmark_function(Function *function);
+
 void run_command_file(std::string file_name);
 void run_command_file_absolute_path(std::string file_name);
 void save_command_file(std::string file_name);
@@ -0,0 +1,165 @@
+#include "plot_file.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+#include "data_manager.hpp"
+#include "global_vars.hpp"
+#include "mapped_file.hpp"
+
+static_assert(std::endian::native == std::endian::little, "The plot file format is little endian.");
+
+static uint64_t align_8(uint64_t offset)
+{
+    return (offset + 7) & ~uint64_t(7);
+}
+
+bool write_plot_file(const std::string& file_name, const std::vector<Plot_Data*>& plot_data, Plot_File_Value_Type value_type)
+{
+    std::ofstream out_file(file_name, std::ios::binary);
+    if (!out_file.is_open()) {
+	logger.log_error("Unable to open file '%s'", file_name.c_str());
+	return false;
+    }
+
+    Plot_File_Header header;
+    std::memcpy(header.magic, PLOT_FILE_MAGIC, sizeof(header.magic));
+    header.version = PLOT_FILE_VERSION;
+    header.column_cnt = uint32_t(plot_data.size());
+
+    const size_t value_size = value_type == PFVT_FLOAT ? sizeof(float) : sizeof(double);
+    std::vector<Plot_File_Column_Header> columns(plot_data.size());
+
+    uint64_t offset = sizeof(Plot_File_Header) + sizeof(Plot_File_Column_Header) * columns.size();
+    for (size_t i = 0; i < plot_data.size(); ++i) {
+	columns[i].header_offset = offset;
+	columns[i].header_size = uint32_t(plot_data[i]->info.header.size());
+	offset += columns[i].header_size;
+    }
+    for (size_t i = 0; i < plot_data.size(); ++i) {
+	const Plot_Data* pd = plot_data[i];
+	offset = align_8(offset);
+	columns[i].size = pd->y.size();
+	columns[i].value_offset = offset;
+	columns[i].value_type = value_type;
+	auto x_it = std::find(plot_data.begin(), plot_data.end(), pd->x);
+	columns[i].x_index = pd->x && x_it != plot_data.end() ? int64_t(x_it - plot_data.begin()) : -1;
+	columns[i].plot_type = uint32_t(pd->info.plot_type);
+	columns[i].color[0] = pd->info.color.r;
+	columns[i].color[1] = pd->info.color.g;
+	columns[i].color[2] = pd->info.color.b;
+	columns[i].color[3] = pd->info.color.a;
+	offset += columns[i].size * value_size;
+    }
+
+    out_file.write((const char*)&header, sizeof(header));
+    out_file.write((const char*)columns.data(), sizeof(Plot_File_Column_Header) * columns.size());
+    for (const auto pd : plot_data) {
+	out_file.write(pd->info.header.data(), pd->info.header.size());
+    }
+
+    std::vector<float> float_buffer;
+    for (size_t i = 0; i < plot_data.size(); ++i) {
+	const char zeros[8] = {};
+	out_file.write(zeros, columns[i].value_offset - uint64_t(out_file.tellp()));
+
+	const Data_Column& y = plot_data[i]->y;
+	if (value_type == PFVT_FLOAT) {
+	    float_buffer.assign(y.begin(), y.end());
+	    out_file.write((const char*)float_buffer.data(), float_buffer.size() * sizeof(float));
+	}
+	else {
+	    out_file.write((const char*)y.data(), y.size() * sizeof(double));
+	}
+    }
+
+    if (!out_file) {
+	logger.log_error("Failed writing file '%s'", file_name.c_str());
+	return false;
+    }
+    return true;
+}
+
+std::vector<Plot_Data*> read_plot_file(const std::string& file_name)
+{
+    // shared by the columns which view into it, it is unmapped once the last of them is changed or deleted.
+    auto mapped_file = std::make_shared<Mapped_File>();
+    const Mapped_File& file = *mapped_file;
+    if (!mapped_file->open(file_name)) {
+	logger.log_error("Failed to open file '%s'.", file_name.c_str());
+	return {};
+    }
+
+    Plot_File_Header header;
+    if (file.size() < sizeof(header)) {
+	logger.log_error("'%s' is not a FasterPlot file.", file_name.c_str());
+	return {};
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, PLOT_FILE_MAGIC, sizeof(header.magic)) != 0) {
+	logger.log_error("'%s' is not a FasterPlot file.", file_name.c_str());
+	return {};
+    }
+    if (header.version != PLOT_FILE_VERSION) {
+	logger.log_error("'%s' has the unsupported version %u.", file_name.c_str(), header.version);
+	return {};
+    }
+
+    if (file.size() < sizeof(header) + uint64_t(header.column_cnt) * sizeof(Plot_File_Column_Header)) {
+	logger.log_error("'%s' is truncated.", file_name.c_str());
+	return {};
+    }
+    std::vector<Plot_File_Column_Header> columns(header.column_cnt);
+    std::memcpy(columns.data(), file.data() + sizeof(header), columns.size() * sizeof(Plot_File_Column_Header));
+
+    // validate everything, before creating any data
+    for (const auto& column : columns) {
+	size_t value_size = column.value_type == PFVT_FLOAT ? sizeof(float) : sizeof(double);
+	bool valid = (column.value_type == PFVT_DOUBLE || column.value_type == PFVT_FLOAT)
+	    && column.header_offset <= file.size() && column.header_size <= file.size() - column.header_offset
+	    && column.value_offset <= file.size() && column.size <= (file.size() - column.value_offset) / value_size
+	    && column.x_index < int64_t(columns.size());
+	if (!valid) {
+	    logger.log_error("'%s' is corrupt or truncated.", file_name.c_str());
+	    return {};
+	}
+    }
+
+    std::vector<Plot_Data*> data_list(columns.size());
+    for (size_t i = 0; i < columns.size(); ++i) {
+	const Plot_File_Column_Header& column = columns[i];
+	Plot_Data* pd = new Plot_Data;
+	pd->info.header.assign(file.data() + column.header_offset, column.header_size);
+	pd->info.plot_type = Plot_Type(column.plot_type);
+	pd->info.color = Color{column.color[0], column.color[1], column.color[2], column.color[3]};
+
+	const char* values = file.data() + column.value_offset;
+	if (column.value_type == PFVT_DOUBLE && column.value_offset % alignof(double) == 0) {
+	    pd->y = Data_Column::view(mapped_file, (const double*)values, column.size);
+	}
+	else {
+	    std::vector<double>& y = pd->y.edit();
+	    y.resize(column.size);
+	    for (size_t k = 0; k < column.size; ++k) {
+		if (column.value_type == PFVT_FLOAT) {
+		    float value;
+		    std::memcpy(&value, values + k * sizeof(float), sizeof(float));
+		    y[k] = value;
+		}
+		else {
+		    std::memcpy(&y[k], values + k * sizeof(double), sizeof(double));
+		}
+	    }
+	}
+	data_list[i] = pd;
+    }
+
+    for (size_t i = 0; i < columns.size(); ++i) {
+	if (columns[i].x_index >= 0 && size_t(columns[i].x_index) != i)
+	    data_list[i]->x = data_list[columns[i].x_index];
+    }
+    return data_list;
+}
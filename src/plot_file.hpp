@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Binary columnar file format of FasterPlot (little endian).
+//
+// Plot_File_Header
+// Plot_File_Column_Header * column_cnt
+// column headers (info.header) as raw characters
+// column values, every column starts at its value_offset, which is aligned to 8 bytes.
+//
+// Loading needs no parsing: double columns are read only views into the memory mapped file (see Data_Column), which are
+// paged in on demand and copied only when they are changed. Float columns are converted on loading.
+
+#define PLOT_FILE_EXTENSION ".fplot"
+
+constexpr char PLOT_FILE_MAGIC[8] = {'F', 'P', 'L', 'O', 'T', 'B', 'I', 'N'};
+constexpr uint32_t PLOT_FILE_VERSION = 1;
+
+enum Plot_File_Value_Type : uint32_t
+{
+    PFVT_DOUBLE = 0,
+    PFVT_FLOAT  = 1,
+};
+
+struct Plot_File_Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t column_cnt;
+};
+
+struct Plot_File_Column_Header
+{
+    uint64_t size;          // number of values
+    uint64_t value_offset;  // from the beginning of the file
+    uint64_t header_offset; // from the beginning of the file
+    uint32_t header_size;
+    uint32_t value_type;    // Plot_File_Value_Type
+    int64_t x_index;        // index of the column used as X, -1 if none
+    uint32_t plot_type;
+    uint8_t color[4];
+};
+
+static_assert(sizeof(Plot_File_Header) == 16);
+static_assert(sizeof(Plot_File_Column_Header) == 48);
+
+struct Plot_Data;
+
+// X references to data which is not written are dropped.
+bool write_plot_file(const std::string& file_name, const std::vector<Plot_Data*>& plot_data, Plot_File_Value_Type value_type);
+std::vector<Plot_Data*> read_plot_file(const std::string& file_name);
@@ -0,0 +1,208 @@
+#include "plot_image.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+
+#include "data_manager.hpp"
+#include "global_vars.hpp"
+
+static Image* draw_image = nullptr;   // drawing on the CPU, while an image is rendered without a window
+static Vec2<int> render_size = {0, 0}; // while an image is rendered
+
+// the image functions of raylib overwrite pixels instead of blending, so colors are blended with the white background first.
+static Color get_opaque_color(Color color)
+{
+    return ColorAlphaBlend(WHITE, color, WHITE);
+}
+
+// Liang-Barsky, lines far outside of the image are not walked pixel by pixel.
+static bool clip_line(Vec2<double>& a, Vec2<double>& b, double width, double height)
+{
+    double t_begin = 0, t_end = 1;
+    const Vec2<double> d = b - a;
+    const double p[4] = {-d.x, d.x, -d.y, d.y};
+    const double q[4] = {a.x + 1, width - a.x, a.y + 1, height - a.y};
+    for (int i = 0; i < 4; ++i) {
+	if (p[i] == 0) {
+	    if (q[i] < 0)
+		return false;
+	    continue;
+	}
+	double t = q[i] / p[i];
+	if (p[i] < 0)
+	    t_begin = std::max(t_begin, t);
+	else
+	    t_end = std::min(t_end, t);
+    }
+    if (t_begin > t_end || !std::isfinite(t_begin) || !std::isfinite(t_end))
+	return false;
+    b = a + d * t_end;
+    a = a + d * t_begin;
+    return true;
+}
+
+void plot_draw_line(Vec2<double> a, Vec2<double> b, float thickness, Color color)
+{
+    if (!draw_image) {
+	DrawLineEx(a, b, thickness, color);
+	return;
+    }
+
+    if (!clip_line(a, b, draw_image->width, draw_image->height))
+	return;
+
+    // thick lines are drawn as parallel lines, one pixel apart
+    const int line_cnt = std::max(1, int(std::round(thickness)));
+    Vec2<double> normal = {a.y - b.y, b.x - a.x};
+    double length = normal.length();
+    normal = length > 0 ? normal / length : Vec2<double>{0, 0};
+    color = get_opaque_color(color);
+    for (int i = 0; i < line_cnt; ++i) {
+	Vec2<double> offset = normal * (double(i) - double(line_cnt - 1) / 2);
+	ImageDrawLine(draw_image, int(std::round(a.x + offset.x)), int(std::round(a.y + offset.y)),
+		      int(std::round(b.x + offset.x)), int(std::round(b.y + offset.y)), color);
+    }
+}
+
+void plot_draw_circle(Vec2<double> center, float radius, Color color)
+{
+    if (!draw_image) {
+	DrawCircle(std::round(center.x), std::round(center.y), radius, color);
+	return;
+    }
+    if (center.x < -radius || center.y < -radius || center.x > draw_image->width + radius || center.y > draw_image->height + radius)
+	return;
+    ImageDrawCircle(draw_image, int(std::round(center.x)), int(std::round(center.y)), std::max(1, int(std::round(radius))), get_opaque_color(color));
+}
+
+void plot_draw_pixel(Vec2<double> position, Color color)
+{
+    if (!draw_image) {
+	DrawPixelV(position, color);
+	return;
+    }
+    ImageDrawPixel(draw_image, int(position.x), int(position.y), get_opaque_color(color));
+}
+
+// The glyphs are drawn one by one from their images. ImageDrawTextEx would need the texture of the font.
+void plot_draw_text(const Font& font, const char* text, Vector2 position, float font_size, Color color)
+{
+    if (!draw_image) {
+	DrawTextEx(font, text, position, font_size, 0, color);
+	return;
+    }
+    if (font.glyphCount == 0)
+	return;
+
+    const float scale = font_size / float(font.baseSize);
+    float x = position.x;
+    for (const char* c = text; *c; ++c) {
+	int idx = GetGlyphIndex(font, *c);
+	const GlyphInfo& glyph = font.glyphs[idx];
+	const Rectangle& rec = font.recs[idx];
+	Rectangle dst_rec = {x + float(glyph.offsetX) * scale, position.y + float(glyph.offsetY) * scale, rec.width * scale, rec.height * scale};
+	ImageDraw(draw_image, glyph.image, Rectangle{0, 0, float(glyph.image.width), float(glyph.image.height)}, dst_rec, color);
+	x += float(glyph.advanceX != 0 ? glyph.advanceX : int(rec.width)) * scale;
+    }
+}
+
+bool is_drawing_image() { return draw_image; }
+
+int get_plot_width()
+{
+    if (render_size.x > 0)
+	return render_size.x;
+    return g_headless_screen_size.x > 0 ? g_headless_screen_size.x : GetScreenWidth();
+}
+
+int get_plot_height()
+{
+    if (render_size.y > 0)
+	return render_size.y;
+    return g_headless_screen_size.y > 0 ? g_headless_screen_size.y : GetScreenHeight();
+}
+
+bool render_plot_image(std::string file_name, int width, int height)
+{
+    if (width <= 0 || height <= 0 || width > MAX_RENDER_SIZE || height > MAX_RENDER_SIZE) {
+	logger.log_error("The size of the image must be between 1 and %d, not %d x %d.", MAX_RENDER_SIZE, width, height);
+	return false;
+    }
+
+    std::filesystem::path path = file_name;
+    if (!path.has_extension())
+	file_name += ".png";
+    std::error_code error;
+    if (path.has_parent_path())
+	std::filesystem::create_directories(path.parent_path(), error);
+
+    // without a window, the camera is not fitted to the first data of the frame (see Data_Manager::update_viewport)
+    if (data_manager.camera.is_undefined())
+	data_manager.fit_camera_to_plot();
+
+    // the same view as on screen, scaled to the image
+    const VP_Camera screen_camera = data_manager.camera;
+    const int screen_width = get_plot_width();
+    const int screen_height = get_plot_height();
+    VP_Camera& camera = data_manager.camera;
+    if (screen_width > 0 && screen_height > 0) {
+	Vec2<double> scale = {double(width) / double(screen_width), double(height) / double(screen_height)};
+	camera.coord_sys.origin = camera.coord_sys.origin * scale;
+	camera.coord_sys.basis_x = camera.coord_sys.basis_x * scale;
+	camera.coord_sys.basis_y = camera.coord_sys.basis_y * scale;
+    }
+    render_size = {width, height};
+
+    Image image;
+    if (IsWindowReady()) {
+	RenderTexture2D target = LoadRenderTexture(width, height);
+	BeginTextureMode(target);
+	ClearBackground(WHITE);
+	data_manager.draw();
+	EndTextureMode();
+	image = LoadImageFromTexture(target.texture);
+	ImageFlipVertical(&image);
+	UnloadRenderTexture(target);
+    }
+    else {
+	image = GenImageColor(width, height, WHITE);
+	draw_image = &image;
+	data_manager.draw();
+	draw_image = nullptr;
+    }
+
+    render_size = {0, 0};
+    camera = screen_camera;
+
+    bool success = ExportImage(image, file_name.c_str());
+    UnloadImage(image);
+    if (!success)
+	logger.log_error("Failed to write the image '%s'.", file_name.c_str());
+    return success;
+}
+
+// The same as LoadFontFromMemory, without uploading the atlas as a texture. The glyph images are cut from the atlas
+// (gray and alpha) and converted to the format of the rendered images, so drawing them does not convert them every time.
+Font load_image_font(const unsigned char* file_data, int data_size, int font_size)
+{
+    constexpr int GLYPH_CNT = 95;
+    constexpr int GLYPH_PADDING = 4;
+
+    Font font = {};
+    font.baseSize = font_size;
+    font.glyphCount = GLYPH_CNT;
+    font.glyphPadding = GLYPH_PADDING;
+    font.glyphs = LoadFontData(file_data, data_size, font_size, nullptr, GLYPH_CNT, FONT_DEFAULT);
+    if (!font.glyphs)
+	return Font{};
+
+    Image atlas = GenImageFontAtlas(font.glyphs, &font.recs, GLYPH_CNT, font_size, GLYPH_PADDING, 0);
+    for (int i = 0; i < GLYPH_CNT; ++i) {
+	UnloadImage(font.glyphs[i].image);
+	font.glyphs[i].image = ImageFromImage(atlas, font.recs[i]);
+	ImageFormat(&font.glyphs[i].image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    }
+    UnloadImage(atlas);
+    return font;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+
+#include "raylib.h"
+#include "utils.hpp"
+
+constexpr int MAX_RENDER_SIZE = 16384;
+
+// The plot is drawn with raylib into the window or a render texture, or without a window (and OpenGL context) on the CPU
+// into an image, with the image functions of raylib. The drawing of the data manager goes through these functions.
+void plot_draw_line(Vec2<double> a, Vec2<double> b, float thickness, Color color);
+void plot_draw_circle(Vec2<double> center, float radius, Color color);
+void plot_draw_pixel(Vec2<double> position, Color color);
+void plot_draw_text(const Font& font, const char* text, Vector2 position, float font_size, Color color);
+bool is_drawing_image();
+
+// the size of the window, of the image which is rendered, or the size given to Faster_Plot::init_headless.
+int get_plot_width();
+int get_plot_height();
+
+// Renders the current view, scaled to the size, into an image file (png, unless the file name has another extension).
+// With a window through a render texture, otherwise on the CPU. The size must be between 1 and MAX_RENDER_SIZE.
+bool render_plot_image(std::string file_name, int width, int height);
+
+// A font for drawing on the CPU, it is loaded without an OpenGL context.
+Font load_image_font(const unsigned char* file_data, int data_size, int font_size);
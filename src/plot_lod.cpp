@@ -0,0 +1,185 @@
+#include "plot_lod.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// NaN are neither the minimum nor the maximum of a bucket, if it has other values.
+static bool is_less(double a, double b) { return a < b || (std::isnan(b) && !std::isnan(a)); }
+static bool is_greater(double a, double b) { return a > b || (std::isnan(b) && !std::isnan(a)); }
+
+// the indices are counted from base, the first index of the column.
+static LOD_Bucket merge_buckets(const Data_Column& y, size_t base, LOD_Bucket a, LOD_Bucket b)
+{
+    return { is_less(y[b.min_idx - base], y[a.min_idx - base]) ? b.min_idx : a.min_idx,
+	     is_greater(y[b.max_idx - base], y[a.max_idx - base]) ? b.max_idx : a.max_idx };
+}
+
+static void add_sample(const Data_Column& y, size_t base, LOD_Bucket& bucket, size_t i)
+{
+    bucket.min_idx = is_less(y[i - base], y[bucket.min_idx - base]) ? i : bucket.min_idx;
+    bucket.max_idx = is_greater(y[i - base], y[bucket.max_idx - base]) ? i : bucket.max_idx;
+}
+
+void Plot_LOD::update(const Data_Column& y, uint64_t data_version)
+{
+    if (built_version != data_version) {
+	clear();
+	built_version = data_version;
+    }
+    slide(y);
+    if (built_size > y.size()) {
+	clear();
+    }
+    if (built_size < y.size()) {
+	refresh(y, built_size, y.size(), y.size());
+    }
+}
+
+void Plot_LOD::append(const Data_Column& y)
+{
+    // the pyramid is only built on demand, by update.
+    slide(y);
+    if (built_size > y.size()) {
+	clear();
+    }
+    if (built_size > 0 && built_size < y.size()) {
+	refresh(y, built_size, y.size(), y.size());
+    }
+}
+
+void Plot_LOD::update_value(const Data_Column& y, size_t idx)
+{
+    if (idx < built_size) {
+	refresh(y, idx, idx + 1, built_size);
+    }
+}
+
+// drops the buckets in front of the moved window of a rolling column and updates the first bucket of every level,
+// which may have lost samples. This is O(log n) plus the dropped buckets.
+void Plot_LOD::slide(const Data_Column& y)
+{
+    const size_t first_idx = y.get_first_index();
+    if (built_size == 0 || first_idx == base)
+	return;
+    if (first_idx < base || first_idx - base >= built_size) {
+	clear();
+	return;
+    }
+
+    const size_t dropped = first_idx - base;
+    for (int level = 0; level < get_level_cnt(); ++level) {
+	size_t drop_cnt = std::min(((first_idx / LOD_BASE_BUCKET_SIZE) >> level) - get_first_bucket(level), levels[level].size());
+	levels[level].erase(levels[level].begin(), levels[level].begin() + drop_cnt);
+    }
+    base = first_idx;
+    built_size -= dropped;
+    refresh(y, 0, 1, built_size);
+}
+
+void Plot_LOD::clear()
+{
+    levels.clear();
+    built_size = 0;
+}
+
+// the samples before and after the whole buckets are added one by one, the whole buckets bottom up as in a segment tree.
+LOD_Bucket Plot_LOD::get_range_extrema(const Data_Column& y, size_t begin, size_t end) const
+{
+    begin += base;
+    end += base;
+    LOD_Bucket extrema = {begin, begin};
+    size_t bucket_begin = (begin + LOD_BASE_BUCKET_SIZE - 1) / LOD_BASE_BUCKET_SIZE;
+    size_t bucket_end = end / LOD_BASE_BUCKET_SIZE;
+    if (bucket_begin >= bucket_end) {
+	for (size_t i = begin + 1; i < end; ++i)
+	    add_sample(y, base, extrema, i);
+	return {extrema.min_idx - base, extrema.max_idx - base};
+    }
+
+    for (size_t i = begin + 1; i < bucket_begin * LOD_BASE_BUCKET_SIZE; ++i)
+	add_sample(y, base, extrema, i);
+    for (size_t i = bucket_end * LOD_BASE_BUCKET_SIZE; i < end; ++i)
+	add_sample(y, base, extrema, i);
+
+    for (int level = 0; bucket_begin < bucket_end; ++level) {
+	if (bucket_begin % 2 == 1)
+	    extrema = merge_buckets(y, base, extrema, get_bucket(level, bucket_begin++));
+	if (bucket_end % 2 == 1)
+	    extrema = merge_buckets(y, base, extrema, get_bucket(level, --bucket_end));
+	bucket_begin /= 2;
+	bucket_end /= 2;
+    }
+    return {extrema.min_idx - base, extrema.max_idx - base};
+}
+
+int Plot_LOD::select_level(double samples_per_pixel) const
+{
+    int level = -1;
+    while (level + 1 < get_level_cnt() && double(get_bucket_size(level + 1)) <= samples_per_pixel) {
+	++level;
+    }
+    return level;
+}
+
+// recomputes all buckets covering the samples [begin, end) of the first size samples, on every level.
+void Plot_LOD::refresh(const Data_Column& y, size_t begin, size_t end, size_t size)
+{
+    if (size == 0) {
+	clear();
+	return;
+    }
+
+    if (levels.empty()) {
+	levels.emplace_back();
+	base = y.get_first_index();
+    }
+
+    const size_t last_bucket = (base + size - 1) / LOD_BASE_BUCKET_SIZE;
+    levels[0].resize(last_bucket - get_first_bucket(0) + 1);
+
+    size_t bucket_begin = (base + begin) / LOD_BASE_BUCKET_SIZE;
+    size_t bucket_end = (base + end - 1) / LOD_BASE_BUCKET_SIZE + 1;
+
+    for (size_t b = bucket_begin; b < bucket_end; ++b) {
+	size_t i = std::max(b * LOD_BASE_BUCKET_SIZE, base);
+	size_t i_end = std::min((b + 1) * LOD_BASE_BUCKET_SIZE, base + size);
+	LOD_Bucket bucket = {i, i};
+	for (++i; i < i_end; ++i)
+	    add_sample(y, base, bucket, i);
+	levels[0][b - get_first_bucket(0)] = bucket;
+    }
+
+    // propagate the changed range up the pyramid. The first bucket of a level may have only its second child.
+    int level = 1;
+    for (; levels[level - 1].size() > 1; ++level)
+    {
+	bool new_level = get_level_cnt() <= level;
+	if (new_level) {
+	    levels.emplace_back();
+	}
+	const std::deque<LOD_Bucket>& child = levels[level - 1];
+	std::deque<LOD_Bucket>& parent = levels[level];
+	const size_t child_first = get_first_bucket(level - 1);
+	const size_t parent_first = get_first_bucket(level);
+	parent.resize((last_bucket >> level) - parent_first + 1);
+
+	bucket_begin /= 2;
+	bucket_end = (bucket_end - 1) / 2 + 1;
+	if (new_level) {
+	    // the first bucket does not have to be a parent of the changed ones
+	    bucket_begin = parent_first;
+	    bucket_end = parent_first + parent.size();
+	}
+	for (size_t b = bucket_begin; b < bucket_end; ++b) {
+	    bool has_left = 2 * b >= child_first;
+	    bool has_right = 2 * b + 1 - child_first < child.size();
+	    if (has_left && has_right)
+		parent[b - parent_first] = merge_buckets(y, base, child[2 * b - child_first], child[2 * b + 1 - child_first]);
+	    else
+		parent[b - parent_first] = child[(has_left ? 2 * b : 2 * b + 1) - child_first];
+	}
+    }
+    levels.resize(level);
+
+    built_size = size;
+}
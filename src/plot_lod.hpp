@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "data_column.hpp"
+
+// Level of detail pyramid for drawing large data.
+// Level 0 summarizes buckets of LOD_BASE_BUCKET_SIZE samples, every further level merges two buckets of the level below.
+// A bucket stores the indices of its minimum and maximum, so the polyline first -> min -> max -> last (in index order)
+// of every bucket reproduces the envelope of the full resolution plot.
+// The buckets and their indices count from the first sample of the column (see Data_Column::get_first_index), so when the
+// window of a rolling column moves, only the buckets in front of it are dropped and the first bucket of every level is updated.
+constexpr size_t LOD_BASE_BUCKET_SIZE = 16;
+
+// Below this many samples per pixel column the data is drawn at full resolution.
+constexpr double LOD_MIN_SAMPLES_PER_PIXEL = 4;
+
+struct LOD_Bucket
+{
+    uint64_t min_idx; // of the sample y[min_idx - get_base()]
+    uint64_t max_idx;
+};
+
+struct Plot_LOD
+{
+    // (re)builds the pyramid, if it is out of date with the data.
+    void update(const Data_Column& y, uint64_t data_version);
+
+    // incremental updates, which keep the pyramid in sync with the data. append also follows a moved rolling window.
+    void append(const Data_Column& y);
+    void update_value(const Data_Column& y, size_t idx);
+
+    void clear();
+
+    // The indices of the minimum and maximum of the samples [begin, end), which must not be empty and must be built.
+    // Whole buckets are taken from the pyramid, so this is O(log n). NaN are skipped, unless all samples are NaN.
+    LOD_Bucket get_range_extrema(const Data_Column& y, size_t begin, size_t end) const;
+
+    // returns the coarsest level whose buckets do not span more than samples_per_pixel samples, or -1 if no level qualifies.
+    int select_level(double samples_per_pixel) const;
+
+    size_t get_bucket_size(int level) const { return LOD_BASE_BUCKET_SIZE << level; }
+    int get_level_cnt() const { return int(levels.size()); }
+
+    // Bucket b of a level covers the samples [b * bucket size, (b + 1) * bucket size) counted from the first index of the
+    // column, the buckets [get_first_bucket, get_bucket_end) are available.
+    size_t get_base() const { return base; }
+    size_t get_first_bucket(int level) const { return (base / LOD_BASE_BUCKET_SIZE) >> level; }
+    size_t get_bucket_end(int level) const { return get_first_bucket(level) + levels[level].size(); }
+    const LOD_Bucket& get_bucket(int level, size_t b) const { return levels[level][b - get_first_bucket(level)]; }
+
+private:
+
+    void slide(const Data_Column& y);
+    void refresh(const Data_Column& y, size_t begin, size_t end, size_t size);
+
+    std::vector<std::deque<LOD_Bucket>> levels;
+    uint64_t built_version = 0;
+    size_t built_size = 0;
+    size_t base = 0; // the first index of the column, which the pyramid is built for
+};
@@ -0,0 +1,346 @@
+#include "plot_renderer.hpp"
+
+#include "raylib.h"
+
+#include <algorithm>
+
+#include "data_manager.hpp"
+
+// Both kinds of quads share the shader: for lines vertexPosition.xy is this end of the segment, vertexPosition.z the side
+// of the segment and vertexNormal.xy the other end; for points vertexNormal.xy is the corner of the quad and vertexNormal.z = 1.
+// The extrusion happens in screen space, so line width and point size stay in pixels at any zoom.
+static const char *plot_vertex_shader = R"(#version 330
+in vec3 vertexPosition;
+in vec3 vertexNormal;
+out vec2 corner;
+uniform mat4 mvp;
+uniform mat4 data_to_screen;
+uniform float half_width;
+void main()
+{
+    vec2 p = (data_to_screen * vec4(vertexPosition.xy, 0.0, 1.0)).xy;
+    if (vertexNormal.z > 0.5) {
+        corner = vertexNormal.xy;
+        p += vertexNormal.xy * half_width;
+    }
+    else {
+        corner = vec2(0.0);
+        vec2 dir = p - (data_to_screen * vec4(vertexNormal.xy, 0.0, 1.0)).xy;
+        float len = length(dir);
+        if (len > 0.0) {
+            p += vec2(-dir.y, dir.x) / len * vertexPosition.z * half_width;
+        }
+    }
+    gl_Position = mvp * vec4(p, 0.0, 1.0);
+}
+)";
+
+static const char *plot_fragment_shader = R"(#version 330
+in vec2 corner;
+out vec4 finalColor;
+uniform vec4 colDiffuse;
+void main()
+{
+    if (dot(corner, corner) > 1.0) {
+        discard;
+    }
+    finalColor = colDiffuse;
+}
+)";
+
+enum Plot_Shader_State
+{
+    PSS_NOT_LOADED,
+    PSS_LOADED,
+    PSS_FAILED,
+};
+
+static Plot_Shader_State plot_shader_state = PSS_NOT_LOADED;
+static Material plot_material;
+static int plot_shader_loc_data_to_screen = -1;
+static int plot_shader_loc_half_width = -1;
+
+static bool load_plot_shader()
+{
+    if (plot_shader_state == PSS_NOT_LOADED && IsWindowReady()) {
+	Shader shader = LoadShaderFromMemory(plot_vertex_shader, plot_fragment_shader);
+	plot_shader_loc_data_to_screen = GetShaderLocation(shader, "data_to_screen");
+	plot_shader_loc_half_width = GetShaderLocation(shader, "half_width");
+
+	// raylib falls back to its default shader, if the compilation fails.
+	if (IsShaderReady(shader) && plot_shader_loc_data_to_screen != -1) {
+	    plot_material = LoadMaterialDefault();
+	    plot_material.shader = shader;
+	    plot_shader_state = PSS_LOADED;
+	}
+	else {
+	    plot_shader_state = PSS_FAILED;
+	}
+    }
+    return plot_shader_state == PSS_LOADED;
+}
+
+void unload_plot_renderer_resources()
+{
+    if (plot_shader_state == PSS_LOADED) {
+	UnloadMaterial(plot_material); // also unloads the shader
+    }
+    plot_shader_state = PSS_NOT_LOADED;
+}
+
+// indices of the two triangles of every quad, the same for every chunk.
+static unsigned short* get_quad_indices()
+{
+    static std::vector<unsigned short> indices;
+    if (indices.empty()) {
+	indices.resize(PLOT_RENDERER_CHUNK_SIZE * 6);
+	for (size_t q = 0; q < PLOT_RENDERER_CHUNK_SIZE; ++q) {
+	    unsigned short v = (unsigned short)(q * 4);
+	    unsigned short quad[6] = {v, (unsigned short)(v + 1), (unsigned short)(v + 2), (unsigned short)(v + 2), (unsigned short)(v + 1), (unsigned short)(v + 3)};
+	    std::copy(quad, quad + 6, indices.begin() + q * 6);
+	}
+    }
+    return indices.data();
+}
+
+// the vertices of a whole chunk of degenerate quads, which are not drawn.
+static float* get_zero_vertices()
+{
+    static std::vector<float> zeros(PLOT_RENDERER_CHUNK_SIZE * 4 * 3, 0);
+    return zeros.data();
+}
+
+static Plot_Renderer_Chunk new_chunk()
+{
+    Plot_Renderer_Chunk chunk;
+    chunk.mesh.vertexCount = PLOT_RENDERER_CHUNK_SIZE * 4;
+    chunk.mesh.triangleCount = PLOT_RENDERER_CHUNK_SIZE * 2;
+    chunk.mesh.vertices = get_zero_vertices();
+    chunk.mesh.normals = get_zero_vertices();
+    chunk.mesh.indices = get_quad_indices();
+    UploadMesh(&chunk.mesh, true);
+
+    // raylib would free the CPU side arrays on unload. The indices must stay set, since DrawMesh checks them to draw indexed.
+    chunk.mesh.vertices = nullptr;
+    chunk.mesh.normals = nullptr;
+    return chunk;
+}
+
+static void unload_chunk(Plot_Renderer_Chunk& chunk)
+{
+    if (IsWindowReady()) {
+	chunk.mesh.indices = nullptr;
+	UnloadMesh(chunk.mesh);
+    }
+}
+
+static void unload_chunks(Plot_Renderer_Buffer& buffer)
+{
+    for (auto& chunk : buffer.chunks)
+	unload_chunk(chunk);
+    buffer.chunks.clear();
+    buffer.size = 0;
+}
+
+void Plot_Renderer::unload()
+{
+    unload_chunks(line_buffer);
+    unload_chunks(point_buffer);
+    uploaded = false;
+}
+
+void Plot_Renderer::sync(Plot_Data* pd)
+{
+    size_t size = pd->size();
+    size_t first_idx = pd->y.get_first_index();
+    size_t x_first_idx = pd->x ? pd->x->y.get_first_index() : 0;
+    bool reupload = !uploaded || pd->data_version != uploaded_version || pd->x != uploaded_x
+	|| (pd->x && pd->x->data_version != uploaded_x_version);
+
+    // a moved rolling window keeps its uploaded elements, if its X moved along with it
+    if (!reupload && (first_idx != base || x_first_idx != x_base)) {
+	size_t dropped = first_idx - base;
+	reupload = first_idx < base || (pd->x && x_first_idx - x_base != dropped) || dropped >= std::max(line_buffer.size, point_buffer.size)
+	    || first_idx - anchor_base > PLOT_RENDERER_MAX_ANCHOR_DISTANCE;
+	if (!reupload) {
+	    slide(dropped);
+	    x_base = x_first_idx;
+	}
+    }
+    reupload = reupload || size < line_buffer.size || size < point_buffer.size;
+
+    if (reupload) {
+	unload();
+	base = first_idx;
+	x_base = x_first_idx;
+	first_chunk = first_idx / PLOT_RENDERER_CHUNK_SIZE;
+	anchor_base = first_idx;
+	anchor_x = pd->x ? pd->x->y[0] : double(first_idx);
+	anchor_y = pd->y[0];
+	uploaded = true;
+	uploaded_version = pd->data_version;
+	uploaded_x = pd->x;
+	uploaded_x_version = pd->x ? pd->x->data_version : 0;
+    }
+}
+
+// Moves the buffers along with the window of a rolling column. The chunks in front of the window are released and the
+// elements of the first chunk in front of it become degenerate quads, so only the dropped elements are touched.
+void Plot_Renderer::slide(size_t dropped)
+{
+    const size_t new_base = base + dropped;
+    const size_t new_first_chunk = new_base / PLOT_RENDERER_CHUNK_SIZE;
+    for (Plot_Renderer_Buffer* buffer : {&line_buffer, &point_buffer}) {
+	buffer->size = buffer->size > dropped ? buffer->size - dropped : 0;
+
+	size_t drop_cnt = std::min(new_first_chunk - first_chunk, buffer->chunks.size());
+	for (size_t c = 0; c < drop_cnt; ++c)
+	    unload_chunk(buffer->chunks[c]);
+	buffer->chunks.erase(buffer->chunks.begin(), buffer->chunks.begin() + drop_cnt);
+
+	if (!buffer->chunks.empty()) {
+	    Plot_Renderer_Chunk& chunk = buffer->chunks[0];
+	    size_t chunk_start = new_first_chunk * PLOT_RENDERER_CHUNK_SIZE;
+	    size_t hide_begin = std::max(base, chunk_start) - chunk_start;
+	    size_t hide_end = std::min(new_base - chunk_start, chunk.cnt);
+	    if (hide_begin < hide_end) {
+		int offset = int(hide_begin * 4 * 3 * sizeof(float));
+		int byte_size = int((hide_end - hide_begin) * 4 * 3 * sizeof(float));
+		UpdateMeshBuffer(chunk.mesh, 0, get_zero_vertices(), byte_size, offset);
+		UpdateMeshBuffer(chunk.mesh, 2, get_zero_vertices(), byte_size, offset);
+	    }
+	}
+    }
+    base = new_base;
+    first_chunk = new_first_chunk;
+}
+
+// writes the vertices of the elements (segments or points) [begin, end) to the GPU.
+void Plot_Renderer::write(Plot_Data* pd, Plot_Renderer_Buffer& buffer, bool lines, size_t begin, size_t end)
+{
+    if (begin >= end)
+	return;
+
+    auto get_point = [&](size_t ix) {
+	return Vector2{float((pd->x ? pd->x->y[ix] : double(base + ix)) - anchor_x), float(pd->y[ix] - anchor_y)};
+    };
+
+    std::vector<float> positions;
+    std::vector<float> normals;
+
+    // the chunks and their elements count from the first index of the column
+    for (size_t c = (base + begin) / PLOT_RENDERER_CHUNK_SIZE; c <= (base + end - 1) / PLOT_RENDERER_CHUNK_SIZE; ++c)
+    {
+	while (buffer.chunks.size() <= c - first_chunk) {
+	    buffer.chunks.push_back(new_chunk());
+	}
+	Plot_Renderer_Chunk& chunk = buffer.chunks[c - first_chunk];
+
+	size_t chunk_begin = std::max(base + begin, c * PLOT_RENDERER_CHUNK_SIZE);
+	size_t chunk_end = std::min(base + end, (c + 1) * PLOT_RENDERER_CHUNK_SIZE);
+	positions.clear();
+	normals.clear();
+
+	for (size_t e = chunk_begin - base; e < chunk_end - base; ++e) {
+	    if (lines) {
+		Vector2 a = get_point(e);
+		Vector2 b = get_point(e + 1);
+		positions.insert(positions.end(), {a.x, a.y, 1, a.x, a.y, -1, b.x, b.y, -1, b.x, b.y, 1});
+		normals.insert(normals.end(), {b.x, b.y, 0, b.x, b.y, 0, a.x, a.y, 0, a.x, a.y, 0});
+	    }
+	    else {
+		Vector2 p = get_point(e);
+		positions.insert(positions.end(), {p.x, p.y, 0, p.x, p.y, 0, p.x, p.y, 0, p.x, p.y, 0});
+		normals.insert(normals.end(), {-1, -1, 1, -1, 1, 1, 1, -1, 1, 1, 1, 1});
+	    }
+	}
+
+	int offset = int((chunk_begin - c * PLOT_RENDERER_CHUNK_SIZE) * 4 * 3 * sizeof(float));
+	UpdateMeshBuffer(chunk.mesh, 0, positions.data(), int(positions.size() * sizeof(float)), offset);
+	UpdateMeshBuffer(chunk.mesh, 2, normals.data(), int(normals.size() * sizeof(float)), offset);
+	chunk.cnt = std::max(chunk.cnt, chunk_end - c * PLOT_RENDERER_CHUNK_SIZE);
+    }
+}
+
+void Plot_Renderer::update_value(Plot_Data* pd, size_t idx)
+{
+    if (!uploaded || pd->size() == 0)
+	return;
+    sync(pd); // the window of a rolling data may have moved since the last draw
+
+    if (idx < point_buffer.size) {
+	write(pd, point_buffer, false, idx, idx + 1);
+    }
+    if (idx < line_buffer.size) {
+	write(pd, line_buffer, true, idx > 0 ? idx - 1 : 0, std::min(idx + 1, line_buffer.size - 1));
+    }
+}
+
+void Plot_Renderer::draw_buffer(Plot_Renderer_Buffer& buffer, float half_width, const std::vector<X_Index_Range>& ranges, bool lines)
+{
+    SetShaderValue(plot_material.shader, plot_shader_loc_half_width, &half_width, SHADER_UNIFORM_FLOAT);
+
+    const Matrix identity = {1, 0, 0, 0,
+			     0, 1, 0, 0,
+			     0, 0, 1, 0,
+			     0, 0, 0, 1};
+
+    // a chunk is drawn as a whole, once, even if several ranges touch it.
+    size_t c_drawn_end = 0;
+    for (const X_Index_Range& range : ranges) {
+	size_t begin = lines && range.begin > 0 ? range.begin - 1 : range.begin;
+	size_t c_end = std::min(buffer.chunks.size(), (base + range.end + PLOT_RENDERER_CHUNK_SIZE - 1) / PLOT_RENDERER_CHUNK_SIZE - first_chunk);
+	for (size_t c = std::max((base + begin) / PLOT_RENDERER_CHUNK_SIZE - first_chunk, c_drawn_end); c < c_end; ++c) {
+	    Mesh mesh = buffer.chunks[c].mesh;
+	    mesh.triangleCount = int(buffer.chunks[c].cnt * 2);
+	    DrawMesh(mesh, plot_material, identity);
+	}
+	c_drawn_end = std::max(c_drawn_end, c_end);
+    }
+}
+
+bool Plot_Renderer::draw(Plot_Data* pd, const VP_Camera& camera, const std::vector<X_Index_Range>& ranges)
+{
+    size_t size = pd->size();
+    if (size == 0 || size > PLOT_RENDERER_MAX_POINTS || !load_plot_shader())
+	return false;
+
+    sync(pd);
+
+    bool draw_lines = pd->info.plot_type & PT_INTERP_LINEAR;
+    bool draw_points = pd->info.plot_type & PT_DISCRETE;
+
+    if (draw_lines && line_buffer.size < size) {
+	write(pd, line_buffer, true, line_buffer.size > 0 ? line_buffer.size - 1 : 0, size - 1);
+	line_buffer.size = size;
+    }
+    if (draw_points && point_buffer.size < size) {
+	write(pd, point_buffer, false, point_buffer.size, size);
+	point_buffer.size = size;
+    }
+
+    // data space (relative to the anchor) to screen space, the same affine transformation as Coordinate_System::transform_to.
+    const Coordinate_System& cs = camera.coord_sys;
+    // without X, the elements are placed by their first index based position, but drawn at their index in the window
+    Vec2<double> anchor = Vec2<double>{pd->x ? anchor_x : anchor_x - double(base), anchor_y} + camera.origin_offset;
+    Matrix data_to_screen = {
+	float(cs.basis_x.x), float(cs.basis_y.x), 0, float(cs.origin.x + cs.basis_x.x * anchor.x + cs.basis_y.x * anchor.y),
+	float(cs.basis_x.y), float(cs.basis_y.y), 0, float(cs.origin.y + cs.basis_x.y * anchor.x + cs.basis_y.y * anchor.y),
+	0, 0, 1, 0,
+	0, 0, 0, 1,
+    };
+
+    // switching the shader flushes the batch of everything drawn immediately before, which keeps the draw order.
+    BeginShaderMode(plot_material.shader);
+    SetShaderValueMatrix(plot_material.shader, plot_shader_loc_data_to_screen, data_to_screen);
+    plot_material.maps[MATERIAL_MAP_DIFFUSE].color = pd->info.color;
+
+    if (draw_lines) {
+	draw_buffer(line_buffer, pd->info.thickness / 6.f, ranges, true);
+    }
+    if (draw_points) {
+	draw_buffer(point_buffer, pd->info.thickness / 2.f, ranges, false);
+    }
+    EndShaderMode();
+    return true;
+}
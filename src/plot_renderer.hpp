@@ -0,0 +1,73 @@
+#pragma once
+
+#include "raylib.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "plot_x_index.hpp"
+
+struct Plot_Data;
+struct VP_Camera;
+
+// Every chunk holds this many segments (or points), each made of 4 vertices, so unsigned short indices suffice.
+constexpr size_t PLOT_RENDERER_CHUNK_SIZE = 16384;
+// Larger data is drawn through the LOD and culling path instead, to limit the GPU memory usage.
+constexpr size_t PLOT_RENDERER_MAX_POINTS = size_t(1) << 21;
+// The index X of a moving rolling window is uploaded relative to the anchor as float, which is exact below 2^24.
+// Everything is uploaded again, once the window moved this far from the anchor.
+constexpr size_t PLOT_RENDERER_MAX_ANCHOR_DISTANCE = size_t(1) << 23;
+
+struct Plot_Renderer_Chunk
+{
+    Mesh mesh = {};
+    size_t cnt = 0;
+};
+
+struct Plot_Renderer_Buffer
+{
+    std::vector<Plot_Renderer_Chunk> chunks; // chunks[c] holds the elements from (first_chunk + c) * PLOT_RENDERER_CHUNK_SIZE on
+    size_t size = 0; // number of uploaded points
+};
+
+// Retained renderer of a Plot_Data. The vertices are uploaded once into dynamic vertex buffers (in data space, relative to
+// an anchor point) and the camera is a shader uniform, so panning and zooming never upload anything.
+// The buffers are synced lazily on draw: appends upload the new tail, update_value the touched vertices and any other
+// change of the data (its data_version, or its X) uploads everything again.
+// The elements are placed by their index counted from the first index of the column (see Data_Column::get_first_index).
+// When the window of a rolling column moves, the chunks in front of it are dropped and only the new tail is uploaded.
+struct Plot_Renderer
+{
+    Plot_Renderer() {}
+    Plot_Renderer(const Plot_Renderer&) {} // GPU buffers are never shared, a copy uploads its own on draw.
+    Plot_Renderer& operator=(const Plot_Renderer&) { unload(); return *this; }
+    ~Plot_Renderer() { unload(); }
+
+    // draws the points in the (ascending) ranges. Returns false, if the renderer is unavailable and nothing was drawn.
+    bool draw(Plot_Data* pd, const VP_Camera& camera, const std::vector<X_Index_Range>& ranges);
+    void update_value(Plot_Data* pd, size_t idx);
+    void unload();
+
+private:
+
+    void sync(Plot_Data* pd);
+    void slide(size_t dropped);
+    void write(Plot_Data* pd, Plot_Renderer_Buffer& buffer, bool lines, size_t begin, size_t end);
+    void draw_buffer(Plot_Renderer_Buffer& buffer, float half_width, const std::vector<X_Index_Range>& ranges, bool lines);
+
+    Plot_Renderer_Buffer line_buffer;
+    Plot_Renderer_Buffer point_buffer;
+    double anchor_x = 0;
+    double anchor_y = 0;
+    size_t base = 0;        // the first index of the column, which is uploaded
+    size_t x_base = 0;      // and of its X
+    size_t first_chunk = 0; // of the buffers
+    size_t anchor_base = 0; // the base, when the anchor was set
+    bool uploaded = false;
+    uint64_t uploaded_version = 0;
+    const Plot_Data* uploaded_x = nullptr;
+    uint64_t uploaded_x_version = 0;
+};
+
+void unload_plot_renderer_resources();
@@ -0,0 +1,150 @@
+#include "plot_x_index.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+// the end of the blocks covering the segments of size samples from base on.
+static size_t get_block_end(size_t base, size_t size)
+{
+    return size <= 1 ? base / X_INDEX_BLOCK_SIZE + size : (base + size - 2) / X_INDEX_BLOCK_SIZE + 1;
+}
+
+void Plot_X_Index::update(const Data_Column& x, uint64_t data_version)
+{
+    if (built_version != data_version) {
+	clear();
+	built_version = data_version;
+    }
+    slide(x);
+    if (built_size > x.size()) {
+	clear();
+    }
+    if (built_size < x.size()) {
+	refresh(x, built_size, x.size(), x.size());
+    }
+}
+
+void Plot_X_Index::append(const Data_Column& x)
+{
+    // the index is only built on demand, for data which is used as X.
+    slide(x);
+    if (built_size > x.size()) {
+	clear();
+    }
+    if (built_size > 0 && built_size < x.size()) {
+	refresh(x, built_size, x.size(), x.size());
+    }
+}
+
+void Plot_X_Index::update_value(const Data_Column& x, size_t idx)
+{
+    if (idx < built_size) {
+	refresh(x, idx, idx + 1, built_size);
+    }
+}
+
+// drops the blocks in front of the moved window of a rolling column and updates the first block.
+// Dropping samples can only make the data more ordered, the order is kept until the next full rebuild.
+void Plot_X_Index::slide(const Data_Column& x)
+{
+    const size_t first_idx = x.get_first_index();
+    if (built_size == 0 || first_idx == base)
+	return;
+    if (first_idx < base || first_idx - base >= built_size) {
+	clear();
+	return;
+    }
+
+    const size_t dropped = first_idx - base;
+    size_t drop_cnt = std::min(first_idx / X_INDEX_BLOCK_SIZE - base / X_INDEX_BLOCK_SIZE, blocks.size());
+    blocks.erase(blocks.begin(), blocks.begin() + drop_cnt);
+    base = first_idx;
+    built_size -= dropped;
+    refresh(x, 0, 1, built_size);
+}
+
+void Plot_X_Index::clear()
+{
+    blocks.clear();
+    increasing = true;
+    decreasing = true;
+    built_size = 0;
+}
+
+// recomputes the order and the blocks for the changed samples [begin, end) of the first size samples.
+// A changed value can only make the data less ordered here, a full rebuild is needed to detect it becoming monotonic again.
+void Plot_X_Index::refresh(const Data_Column& x, size_t begin, size_t end, size_t size)
+{
+    if (size == 0) {
+	clear();
+	return;
+    }
+    if (blocks.empty()) {
+	base = x.get_first_index();
+    }
+
+    for (size_t i = std::max(begin, size_t(1)); i < std::min(end + 1, size); ++i) {
+	increasing = increasing && x[i - 1] <= x[i];
+	decreasing = decreasing && x[i - 1] >= x[i];
+    }
+
+    const size_t first_block = base / X_INDEX_BLOCK_SIZE;
+    blocks.resize(get_block_end(base, size) - first_block);
+    size_t block_begin = std::max((begin > 0 ? base + begin - 1 : base) / X_INDEX_BLOCK_SIZE, first_block);
+    size_t block_end = std::min((base + end - 1) / X_INDEX_BLOCK_SIZE + 1, first_block + blocks.size());
+
+    for (size_t b = block_begin; b < block_end; ++b) {
+	X_Index_Block block = {std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()};
+	size_t i_end = std::min((b + 1) * X_INDEX_BLOCK_SIZE + 1, base + size);
+	for (size_t i = std::max(b * X_INDEX_BLOCK_SIZE, base); i < i_end; ++i) {
+	    block.min = std::min(block.min, x[i - base]); // NaN is ignored, since the comparisons fail
+	    block.max = std::max(block.max, x[i - base]);
+	}
+	blocks[b - first_block] = block;
+    }
+
+    built_size = size;
+}
+
+void Plot_X_Index::get_visible_ranges(const Data_Column& x, size_t size, double min_x, double max_x, std::vector<X_Index_Range>& ranges) const
+{
+    size = std::min(size, built_size);
+
+    if (increasing || decreasing)
+    {
+	// one extra sample on each side, for the segments leaving the screen.
+	size_t lo, hi;
+	if (increasing) {
+	    lo = std::lower_bound(x.begin(), x.begin() + size, min_x) - x.begin();
+	    hi = std::upper_bound(x.begin(), x.begin() + size, max_x) - x.begin();
+	}
+	else {
+	    lo = std::lower_bound(x.begin(), x.begin() + size, max_x, std::greater<double>()) - x.begin();
+	    hi = std::upper_bound(x.begin(), x.begin() + size, min_x, std::greater<double>()) - x.begin();
+	}
+	size_t begin = lo > 0 ? lo - 1 : 0;
+	size_t end = std::min(hi + 1, size);
+	if (begin < end)
+	    ranges.push_back({begin, end});
+	return;
+    }
+
+    // neighbouring visible blocks are merged into one range
+    const size_t first_block = base / X_INDEX_BLOCK_SIZE;
+    size_t block_end = std::min(get_block_end(base, size), first_block + blocks.size());
+    bool in_range = false;
+    for (size_t b = first_block; b < block_end; ++b)
+    {
+	const X_Index_Block& block = blocks[b - first_block];
+	if (block.max < min_x || block.min > max_x) {
+	    in_range = false;
+	    continue;
+	}
+	if (!in_range) {
+	    ranges.push_back({std::max(b * X_INDEX_BLOCK_SIZE, base) - base, 0});
+	    in_range = true;
+	}
+	ranges.back().end = std::min((b + 1) * X_INDEX_BLOCK_SIZE + 1, base + size) - base;
+    }
+}
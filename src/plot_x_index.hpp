@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "data_column.hpp"
+
+// Index of a data set which is used as the X of other data, for finding the samples which are on screen.
+// If the values are monotonic, the visible range is found with a binary search. Otherwise the values are summarized in
+// blocks of X_INDEX_BLOCK_SIZE segments, which store the X range they cover, and only the blocks overlapping the screen are drawn.
+// Like the buckets of Plot_LOD, the blocks count from the first index of the column, so a moved rolling window drops blocks in front.
+constexpr size_t X_INDEX_BLOCK_SIZE = 256;
+
+struct X_Index_Range
+{
+    size_t begin;
+    size_t end;
+};
+
+struct X_Index_Block
+{
+    double min;
+    double max;
+};
+
+struct Plot_X_Index
+{
+    // (re)builds the index, if it is out of date with the data.
+    void update(const Data_Column& x, uint64_t data_version);
+
+    // incremental updates, which keep the index in sync with the data. append also follows a moved rolling window.
+    void append(const Data_Column& x);
+    void update_value(const Data_Column& x, size_t idx);
+
+    void clear();
+
+    // adds the index ranges (below size) to ranges, which contain every sample and every segment with an X in [min_x, max_x].
+    void get_visible_ranges(const Data_Column& x, size_t size, double min_x, double max_x, std::vector<X_Index_Range>& ranges) const;
+
+    bool is_increasing() const { return increasing; }
+    bool is_decreasing() const { return decreasing; }
+
+private:
+
+    void slide(const Data_Column& x);
+    void refresh(const Data_Column& x, size_t begin, size_t end, size_t size);
+
+    // block b covers the samples [b * X_INDEX_BLOCK_SIZE, (b + 1) * X_INDEX_BLOCK_SIZE] counted from the first index of the
+    // column, blocks[0] is block base / X_INDEX_BLOCK_SIZE.
+    std::deque<X_Index_Block> blocks;
+    bool increasing = true;
+    bool decreasing = true;
+    uint64_t built_version = 0;
+    size_t built_size = 0;
+    size_t base = 0; // the first index of the column, which the index is built for
+};
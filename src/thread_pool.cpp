@@ -0,0 +1,85 @@
+#include "thread_pool.hpp"
+
+Thread_Pool::~Thread_Pool()
+{
+    {
+	std::lock_guard<std::mutex> lock(mutex);
+	stopping = true;
+    }
+    work_available.notify_all();
+    for (auto& thread : threads)
+	thread.join();
+}
+
+void Thread_Pool::run(size_t task_cnt, const std::function<void(size_t)>& task)
+{
+    std::lock_guard<std::mutex> run_lock(run_mutex);
+
+    if (task_cnt <= 1 || get_thread_cnt() == 1) {
+	for (size_t i = 0; i < task_cnt; ++i)
+	    task(i);
+	return;
+    }
+
+    if (threads.empty()) {
+	for (size_t i = 1; i < get_thread_cnt(); ++i)
+	    threads.emplace_back(&Thread_Pool::work, this);
+    }
+
+    {
+	std::lock_guard<std::mutex> lock(mutex);
+	this->task = &task;
+	this->task_cnt = task_cnt;
+	next_task = 0;
+	finished_cnt = 0;
+	++generation;
+    }
+    work_available.notify_all();
+
+    do_tasks(&task, task_cnt);
+
+    // no worker may still be inside this run, when the next one starts
+    std::unique_lock<std::mutex> lock(mutex);
+    work_done.wait(lock, [&]() { return finished_cnt == task_cnt && working_cnt == 0; });
+    this->task = nullptr;
+}
+
+void Thread_Pool::do_tasks(const std::function<void(size_t)>* task, size_t task_cnt)
+{
+    size_t done_cnt = 0;
+    for (size_t i = next_task++; i < task_cnt; i = next_task++) {
+	(*task)(i);
+	++done_cnt;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    finished_cnt += done_cnt;
+}
+
+void Thread_Pool::work()
+{
+    uint64_t done_generation = 0;
+    while (true)
+    {
+	const std::function<void(size_t)>* run_task;
+	size_t run_task_cnt;
+	{
+	    std::unique_lock<std::mutex> lock(mutex);
+	    work_available.wait(lock, [&]() { return stopping || (task && generation != done_generation); });
+	    if (stopping)
+		return;
+	    done_generation = generation;
+	    run_task = task;
+	    run_task_cnt = task_cnt;
+	    ++working_cnt;
+	}
+
+	do_tasks(run_task, run_task_cnt);
+
+	{
+	    std::lock_guard<std::mutex> lock(mutex);
+	    --working_cnt;
+	}
+	work_done.notify_all();
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker threads which are kept alive between runs, they are started on the first run.
+// run() calls task(i) for every i < task_cnt and blocks until all are done, the calling thread works as well.
+// One run at a time, tasks must not call run() themselves.
+class Thread_Pool
+{
+public:
+
+    ~Thread_Pool();
+
+    void run(size_t task_cnt, const std::function<void(size_t)>& task);
+    size_t get_thread_cnt() const { return std::max(1u, std::thread::hardware_concurrency()); }
+
+private:
+
+    void work();
+    void do_tasks(const std::function<void(size_t)>* task, size_t task_cnt);
+
+    std::vector<std::thread> threads;
+    std::mutex run_mutex;
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable work_done;
+    const std::function<void(size_t)>* task = nullptr;
+    size_t task_cnt = 0;
+    std::atomic<size_t> next_task = 0;
+    size_t finished_cnt = 0;
+    size_t working_cnt = 0; // workers which took part in the current run and did not leave it yet
+    uint64_t generation = 0;
+    bool stopping = false;
+};
+
+inline Thread_Pool thread_pool;
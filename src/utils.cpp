@@ -11,7 +11,7 @@
 void Logger::log_help_message()
 {
     printf(UTILS_RED "Basics " UTILS_END_COLOR "\n\
-- Load a file containing comma seperated values, by dropping it on the window.\n\
+- Load a file containing comma seperated values, by dropping it on the window. It is shown while it is loading in the background.\n\
 - Run a script file containing commands, by dropping it on the window (there is also a " UTILS_BRIGHT_BLACK "run script" UTILS_END_COLOR " command).\n\
 \n\
 " UTILS_RED "Reverting commands " UTILS_END_COLOR "\n\
@@ -27,6 +27,7 @@ When loading a new file, you can only revert back up until this event.\n\
 - Zoom the X-axis by scrolling while pressing left-shift.\n\
 - Zoom the Y-axis by scrolling while pressing left-ctrl.\n\
 - Fit the window to the content by pressing space.\n\
+- Fit only the Y-axis to the content in the visible X range by pressing left-shift and space.\n\
 \n\
 " UTILS_RED "Commands " UTILS_END_COLOR "\n\
 The commands are explained mostly by examples.\n\
@@ -54,11 +55,26 @@ The commands as well as infos and errors are written to the shell.\n\
   - " UTILS_BRIGHT_BLACK "function 0 = fit sinusoid data 3 0" UTILS_END_COLOR " (with 0 refine iterations)\n\
   - " UTILS_BRIGHT_BLACK "function new = fit sinusoid data 3 10" UTILS_END_COLOR " (with 10 refine iterations)\n\
   - " UTILS_BRIGHT_BLACK "function new \"my fit of data 0\" = fit sinusoid data 0 0,100,1000" UTILS_END_COLOR " (with 0,10,1000 refine iterations)\n\
+  The parameters are refined with the Levenberg-Marquardt method, until the fit converges or the maximum number of iterations is reached.\n\
+  A typed fit runs in the background, other commands have to wait until it is done, or it is canceled with " UTILS_BRIGHT_BLACK "cancel" UTILS_END_COLOR ".\n\
   \n\
   " UTILS_BLUE "help" UTILS_END_COLOR "\n\
   Prints this documentation to the shell.\n\
   - " UTILS_BRIGHT_BLACK "help" UTILS_END_COLOR "\n\
   \n\
+  " UTILS_BLUE "cancel" UTILS_END_COLOR "\n\
+  Stops loading the dropped files, the data loaded so far is kept. Stops a running fit and reverts it.\n\
+  - " UTILS_BRIGHT_BLACK "cancel" UTILS_END_COLOR "\n\
+  \n\
+  " UTILS_BLUE "bench" UTILS_END_COLOR "\n\
+  Measures how many times per second a function is evaluated, one by one and in batches (generic functions also as op tree).\n\
+  - " UTILS_BRIGHT_BLACK "bench function 0" UTILS_END_COLOR "\n\
+  \n\
+  " UTILS_BLUE "bound" UTILS_END_COLOR "\n\
+  Keeps a parameter of a function within limits when fitting. Without limits the parameter is unbounded again.\n\
+  - " UTILS_BRIGHT_BLACK "bound function 0 c -1 1" UTILS_END_COLOR "\n\
+  - " UTILS_BRIGHT_BLACK "bound function 0 c" UTILS_END_COLOR "\n\
+  \n\
   " UTILS_BLUE "hide" UTILS_END_COLOR "\n\
   Hides objects..\n\
   - " UTILS_BRIGHT_BLACK "hide function 5..10" UTILS_END_COLOR "\n\
@@ -79,9 +95,14 @@ The commands as well as infos and errors are written to the shell.\n\
   - " UTILS_BRIGHT_BLACK "show lines data 1" UTILS_END_COLOR " (enables line visualization)\n\
   \n\
   " UTILS_BLUE "smooth" UTILS_END_COLOR "\n\
-  Averages data over a specified window size.\n\
-  - " UTILS_BRIGHT_BLACK "smooth data 1,2,3 5" UTILS_END_COLOR " (window size 5)\n\
-  - " UTILS_BRIGHT_BLACK "smooth data 8 20" UTILS_END_COLOR " (window size 20)\n\
+  Filters data, by default with a moving average over the given number of values on each side. The data of an iterator are filtered in parallel.\n\
+  - " UTILS_BRIGHT_BLACK "smooth data 1,2,3 5" UTILS_END_COLOR " (averages 11 values)\n\
+  - " UTILS_BRIGHT_BLACK "smooth data 8 20" UTILS_END_COLOR " (averages 41 values)\n\
+  - " UTILS_BRIGHT_BLACK "smooth median data 0 5" UTILS_END_COLOR " (median of 11 values)\n\
+  - " UTILS_BRIGHT_BLACK "smooth gauss data 0 2.5" UTILS_END_COLOR " (gaussian with a standard deviation of 2.5 values)\n\
+  - " UTILS_BRIGHT_BLACK "smooth exp data 0 10" UTILS_END_COLOR " (exponential moving average with a time constant of 10 values)\n\
+  - " UTILS_BRIGHT_BLACK "smooth savgol data 0 10 3" UTILS_END_COLOR " (Savitzky-Golay, cubic polynomial over 21 values, quadratic without the order)\n\
+  - " UTILS_BRIGHT_BLACK "smooth butter data 0 0.05 4" UTILS_END_COLOR " (Butterworth low pass of order 4 with the cutoff at 0.05 / value, order 2 without it)\n\
   \n\
   " UTILS_BLUE "interp" UTILS_END_COLOR "\n\
   Interpolates the data linearly. An integer argument specifies how many times the data should be interpolated (doubled in size).\n\
@@ -98,6 +119,15 @@ The commands as well as infos and errors are written to the shell.\n\
   - " UTILS_BRIGHT_BLACK "data 10 = extrema data 3" UTILS_END_COLOR "\n\
   - " UTILS_BRIGHT_BLACK "data new = extrema data 1,3,5" UTILS_END_COLOR "\n\
   \n\
+  " UTILS_BLUE "fft, psd, conv, xcorr" UTILS_END_COLOR "\n\
+  Spectra, convolution and cross correlation of data, saved in another data object with a new X.\n\
+  The sample interval is taken from the X of the data, which should be equally spaced.\n\
+  - " UTILS_BRIGHT_BLACK "data new = fft data 3" UTILS_END_COLOR " (amplitude over the frequency)\n\
+  - " UTILS_BRIGHT_BLACK "data new = fft data 3 phase" UTILS_END_COLOR "\n\
+  - " UTILS_BRIGHT_BLACK "data new = psd data 3 window hann" UTILS_END_COLOR " (power spectral density, windows: rect, hann, hamming, blackman)\n\
+  - " UTILS_BRIGHT_BLACK "data new = conv data 1 data 2" UTILS_END_COLOR "\n\
+  - " UTILS_BRIGHT_BLACK "data new = xcorr data 1 data 2" UTILS_END_COLOR " (X is the lag of data 2 against data 1)\n\
+  \n\
   " UTILS_BLUE "deleting things " UTILS_END_COLOR "\n\
   - " UTILS_BRIGHT_BLACK "delete data 0..2" UTILS_END_COLOR "\n\
   - " UTILS_BRIGHT_BLACK "delete funciton 4" UTILS_END_COLOR "\n\
@@ -105,6 +135,11 @@ The commands as well as infos and errors are written to the shell.\n\
   Delete specific data points.\n\
   - " UTILS_BRIGHT_BLACK "delete points 100..1000 data 9" UTILS_END_COLOR "\n\
   \n\
+  " UTILS_BLUE "capacity" UTILS_END_COLOR "\n\
+  Keeps only the last values of data, for a rolling window of appended or streamed values.\n\
+  - " UTILS_BRIGHT_BLACK "data 0 capacity 1000000" UTILS_END_COLOR "\n\
+  - " UTILS_BRIGHT_BLACK "data 0..3 capacity 0" UTILS_END_COLOR " (no limit, the default)\n\
+  \n\
   " UTILS_BLUE "exporting data and functions " UTILS_END_COLOR "\n\
   Exports data as comma seperated .txt files or functions as their variable and value form.\n\
   They will be located in the exports folder.\n\
@@ -112,6 +147,16 @@ The commands as well as infos and errors are written to the shell.\n\
   - " UTILS_BRIGHT_BLACK "export data 1,2,3 \"my_data\"" UTILS_END_COLOR " (specified file name)\n\
   - " UTILS_BRIGHT_BLACK "export function 1,2,3 \"my_functions\"" UTILS_END_COLOR "\n\
   \n\
+  Data can also be exported in the binary .fplot format, which loads without parsing (drop it on the window).\n\
+  It keeps the headers, colors, plot types and X references between the exported data.\n\
+  - " UTILS_BRIGHT_BLACK "export data 0..3 \"my_data\" binary" UTILS_END_COLOR " (as doubles)\n\
+  - " UTILS_BRIGHT_BLACK "export data 0..3 binary float" UTILS_END_COLOR " (as floats, half the size)\n\
+  \n\
+  " UTILS_BLUE "render" UTILS_END_COLOR "\n\
+  Renders the current view into an image file (png by default), also without a window. It is not saved to scripts.\n\
+  - " UTILS_BRIGHT_BLACK "render \"plot.png\"" UTILS_END_COLOR " (the size of the window)\n\
+  - " UTILS_BRIGHT_BLACK "render \"frames/frame_0001.png\" 1920 1080" UTILS_END_COLOR "\n\
+  \n\
   " UTILS_BLUE "saving all executed commands to a script " UTILS_END_COLOR "\n\
   Saves .script files to the scripts folder.\n\
   - " UTILS_BRIGHT_BLACK "save script" UTILS_END_COLOR " (default file name save)\n\
@@ -180,143 +225,6 @@ std::pair<char *, size_t> parse_file_cstr(const char *file_name)
     return { data, file_size };
 }
 
-static bool is_whitespace(char c)
-{
-    return c == ' ' || c == '\n' || c == '\t' || c == '\f' || c == '\r' || c == '\v';
-}
-
-static bool is_new_line(char c)
-{
-    return c == '\n' || c == '\f' || c == '\r';
-}
-
-static bool is_digit(char c)
-{
-    return c >= '0' && c <= '9';
-}
-
-static bool is_alpha(char c)
-{
-    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
-}
-
-static void fix_comma_notation(bool inside_string, char* p) {
-    if (inside_string) {
-	if (*p == ',')
-	    *p = '.';
-    }
-}
-
-std::vector<Plot_Data*> parse_numeric_csv_file(const std::string& file_name)
-{
-    std::vector<Plot_Data*> data_list;
-    
-    auto content = parse_file_cstr(file_name.c_str());
-    if (content.second == 0) {
-	return {};
-    }
-    
-    char* p = content.first;
-    size_t file_size = content.second;
-     const char* p_end = p + file_size;
-
-    size_t data_column = 0;
-    if (data_list.size() < data_column + 1)
-	data_list.push_back(new Plot_Data);
-    
-
-    bool inside_string = false;
-
-    char* prev_p = p;
-    
-    while (p < p_end) {
-	
-	prev_p = p;
-	
-	while (p < p_end && is_whitespace(*p)) {
-	    if (is_new_line(*p))
-		data_column = 0;
-	    ++p;
-	}
-
-	if (p < p_end && *p == '\"') {
-	    inside_string = !inside_string;
-	    ++p;
-	}
-
-	if (p < p_end && *p == '#') {
-	    while (p < p_end && *p != '\n') {
-		++p;
-	    }
-	}
-
-	// change coma to dots, if inside a string (fixing , notation in numbers)
-	fix_comma_notation(inside_string, p);
-	if (p < p_end && (is_digit(*p) || (((p[0] == '.') || (p[0] == '+') || (p[0] == '-')) && is_digit(*(p + 1))))) {
-	    bool has_point = (*p == '.');
-	    char* begin = p;
-	    ++p;
-
-	    fix_comma_notation(inside_string, p);
-	    while (p < p_end && (is_digit(*p) || *p == '.' || is_alpha(*p))) {
-		if (has_point && (*p == '.'))
-		    break;
-		has_point |= (*p == '.');
-		++p;
-		fix_comma_notation(inside_string, p);
-	    }
-
-	    // parse time code
-	    if (p < p_end && *p == ':') {
-		double time_s = 0;
-		time_s += std::strtod(begin, &p) * 60 * 60; // hours
-		++p;
-		begin = p;
-		p += 2;
-		time_s += std::strtod(begin, &p) * 60; // minutes
-		++p;
-		begin = p;
-		p += 2;
-		*p = ':';
-		time_s += std::strtod(begin, &p); // seconds
-		++p;
-		begin = p;
-		p += 3;
-		time_s += std::strtod(begin, &p) * 0.001; // milliseconds
-
-		data_list[data_column]->y.push_back(time_s);
-	    }
-	    // parse number
-	    else {
-		data_list[data_column]->y.push_back(std::strtod(begin, &p));
-		if (errno == ERANGE)
-		    std::cout << "Parsed number was out of range\n";
-	    }
-	}
-	
-	if (p < p_end && *p == ',') {
-	    ++data_column;
-	    while (data_list.size() - 1 < data_column)
-		data_list.push_back(new Plot_Data);
-	    ++p;
-	}
-
-	if (p < p_end && p == prev_p && inside_string) {
-	    char* begin = p;
-	    while (p < p_end && inside_string) {
-		++p;
-		if (p < p_end && *p == '\"') {
-		    inside_string = !inside_string;
-		}
-		fix_comma_notation(inside_string, p);
-	    }
-	    data_list[data_column]->info.header += std::string(begin, p - begin);
-	    ++p;
-	}
-    }
-    return data_list;
-}
-
 uint64_t hash_string_view(std::string_view s_v, uint64_t hash) {
     for(size_t i = 0; i < s_v.size(); ++i)
 	hash = (hash * 33) ^ s_v[i];
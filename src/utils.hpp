@@ -125,6 +125,7 @@ struct Vec2
     Vec2<T> operator -(Vec2<T> other) const { return {x - other.x, y - other.y}; }
     Vec2<T> operator *(Vec2<T> other) const { return {x * other.x, y * other.y}; }
     Vec2<T> operator /(Vec2<T> other) const { return {x / other.x, y / other.y}; }
+    bool operator ==(Vec2<T> other) const { return x == other.x && y == other.y; }
     T length() const { return std::sqrt(x*x + y*y); }
     void normalize() { T l = length(); x /= l, y /= l; };
 };
@@ -190,6 +191,24 @@ inline uint64_t get_uuid()
     return id;
 }
 
+// Compensated (Kahan-Babuska) summation.
+struct Kahan_Sum
+{
+    double sum = 0;
+    double compensation = 0;
+
+    void add(double value)
+    {
+	double t = sum + value;
+	if (std::abs(sum) >= std::abs(value))
+	    compensation += (sum - t) + value;
+	else
+	    compensation += (value - t) + sum;
+	sum = t;
+    }
+    double get() const { return sum + compensation; }
+};
+
 
 template<char check_key>
 bool is_key_char_pressed()